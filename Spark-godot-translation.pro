@@ -30,13 +30,59 @@ CONFIG += c++11
 
 SOURCES += \
         appobject.cpp \
+        asynclogger.cpp \
+        baidubackend.cpp \
+        cancellationtoken.cpp \
+        concurrencycontroller.cpp \
+        csvio.cpp \
+        csvtable.cpp \
+        csvtablemodel.cpp \
+        fuzzyindex.cpp \
+        logmodel.cpp \
         main.cpp \
         mainwindow.cpp \
+        metricsmodel.cpp \
+        metricsregistry.cpp \
+        mockbaiduserver.cpp \
+        networksession.cpp \
+        ratelimiter.cpp \
+        retrypolicy.cpp \
+        textnormalizer.cpp \
+        translationbackend.cpp \
+        translationcli.cpp \
+        translationjournal.cpp \
+        translationmanifest.cpp \
+        translationmemory.cpp \
+        translationscheduler.cpp \
+        translationworkqueue.cpp \
         translationworker.cpp
 
 HEADERS += \
         appobject.h \
+        asynclogger.h \
+        baidubackend.h \
+        cancellationtoken.h \
+        concurrencycontroller.h \
+        csvio.h \
+        csvtable.h \
+        csvtablemodel.h \
+        fuzzyindex.h \
+        logmodel.h \
         mainwindow.h \
+        metricsmodel.h \
+        metricsregistry.h \
+        mockbaiduserver.h \
+        networksession.h \
+        ratelimiter.h \
+        retrypolicy.h \
+        textnormalizer.h \
+        translationbackend.h \
+        translationcli.h \
+        translationjournal.h \
+        translationmanifest.h \
+        translationmemory.h \
+        translationscheduler.h \
+        translationworkqueue.h \
         translationworker.h
 
 FORMS += \
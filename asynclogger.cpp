@@ -0,0 +1,283 @@
+﻿#include "asynclogger.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <cstdio>
+
+namespace {
+
+// 后台线程空闲时检查队列的间隔
+const int kIdleWaitMs = 50;
+
+// 缓冲超过这个大小或队列取空时写入文件
+const int kWriteChunkBytes = 64 * 1024;
+
+} // namespace
+
+AsyncLogger *AsyncLogger::instance()
+{
+    static AsyncLogger logger;
+    return &logger;
+}
+
+AsyncLogger::AsyncLogger() : m_head(&m_stub), m_tail(&m_stub)
+{
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    stop();
+
+    // 停止前一刻才入队的消息不再写入文件
+    Node *node;
+    while ((node = pop()) != nullptr) {
+        fwrite(node->data.constData(), 1, size_t(node->data.size()), stderr);
+        delete node;
+    }
+}
+
+void AsyncLogger::setDirectory(const QString &directory)
+{
+    m_directory = directory;
+}
+
+QString AsyncLogger::directory() const
+{
+    return m_directory;
+}
+
+void AsyncLogger::setLevel(Level level)
+{
+    m_level.store(level);
+}
+
+AsyncLogger::Level AsyncLogger::level() const
+{
+    return Level(m_level.load());
+}
+
+void AsyncLogger::setMaxFileSize(qint64 bytes)
+{
+    m_maxFileSize = qMax<qint64>(64 * 1024, bytes);
+}
+
+void AsyncLogger::setKeepDays(int days)
+{
+    m_keepDays = qMax(1, days);
+}
+
+AsyncLogger::Level AsyncLogger::levelFromName(const QString &name, Level defaultLevel)
+{
+    QString lower = name.trimmed().toLower();
+    if (lower == "debug") {
+        return Debug;
+    } else if (lower == "info") {
+        return Info;
+    } else if (lower == "warning") {
+        return Warning;
+    } else if (lower == "critical") {
+        return Critical;
+    }
+    return defaultLevel;
+}
+
+AsyncLogger::Level AsyncLogger::levelOf(QtMsgType type)
+{
+    // QtMsgType的数值不是按严重程度排列的
+    switch (type) {
+    case QtDebugMsg:
+        return Debug;
+    case QtInfoMsg:
+        return Info;
+    case QtWarningMsg:
+        return Warning;
+    case QtCriticalMsg:
+        return Critical;
+    case QtFatalMsg:
+        return Fatal;
+    }
+    return Debug;
+}
+
+bool AsyncLogger::isEnabled(Level level) const
+{
+    return level >= m_level.load();
+}
+
+void AsyncLogger::startLogging()
+{
+    if (isRunning()) {
+        return;
+    }
+    m_stopRequested.store(false);
+    m_running.store(true);
+    start(QThread::LowPriority);
+}
+
+void AsyncLogger::append(const QString &line)
+{
+    QByteArray data = line.toUtf8();
+    data.append('\n');
+    if (!m_running.load()) {
+        fwrite(data.constData(), 1, size_t(data.size()), stderr);
+        return;
+    }
+
+    Node *node = new Node;
+    node->data = data;
+    push(node);
+}
+
+void AsyncLogger::stop()
+{
+    if (!isRunning()) {
+        return;
+    }
+    m_stopRequested.store(true);
+    wait();
+}
+
+void AsyncLogger::push(Node *node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+    Node *prev = m_head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+AsyncLogger::Node *AsyncLogger::pop()
+{
+    Node *tail = m_tail;
+    Node *next = tail->next.load(std::memory_order_acquire);
+    if (tail == &m_stub) {
+        if (!next) {
+            return nullptr;
+        }
+        m_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+
+    // 生产者已交换m_head但还没链接上，下次再取
+    if (tail != m_head.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+
+    // 队列中只剩最后一个节点，放回哨兵节点后才能把它取出
+    push(&m_stub);
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+bool AsyncLogger::drain(QByteArray *buffer)
+{
+    bool any = false;
+    Node *node;
+    while ((node = pop()) != nullptr) {
+        buffer->append(node->data);
+        delete node;
+        any = true;
+        if (buffer->size() >= kWriteChunkBytes) {
+            writeBuffer(buffer);
+        }
+    }
+    return any;
+}
+
+void AsyncLogger::run()
+{
+    QDir().mkpath(m_directory);
+    openFile();
+    removeExpiredFiles();
+
+    QByteArray buffer;
+    while (true) {
+        bool stopping = m_stopRequested.load();
+        // 停止时先标记为不再接收，再取完队列中已有的消息
+        if (stopping) {
+            m_running.store(false);
+        }
+
+        drain(&buffer);
+        if (!buffer.isEmpty()) {
+            writeBuffer(&buffer);
+            m_file.flush();
+        }
+        if (stopping) {
+            drain(&buffer);
+            writeBuffer(&buffer);
+            break;
+        }
+        msleep(kIdleWaitMs);
+    }
+    m_file.close();
+}
+
+void AsyncLogger::writeBuffer(QByteArray *buffer)
+{
+    if (buffer->isEmpty()) {
+        return;
+    }
+    rotateIfNeeded(QDateTime::currentMSecsSinceEpoch());
+    if (m_file.isOpen()) {
+        m_file.write(*buffer);
+    } else {
+        fwrite(buffer->constData(), 1, size_t(buffer->size()), stderr);
+    }
+    buffer->clear();
+}
+
+void AsyncLogger::openFile()
+{
+    m_fileDate = QDate::currentDate().toString("yyyy_MM_dd");
+    QDateTime tomorrow(QDate::currentDate().addDays(1));
+    m_nextDateCheck = tomorrow.toMSecsSinceEpoch();
+
+    // 同一天内文件超过大小上限时依次使用log_日期_1.txt、log_日期_2.txt……
+    m_file.close();
+    while (true) {
+        QString name = m_fileIndex == 0 ? QString("log_%1.txt").arg(m_fileDate)
+                                        : QString("log_%1_%2.txt").arg(m_fileDate).arg(m_fileIndex);
+        m_file.setFileName(QDir(m_directory).filePath(name));
+        if (m_file.size() < m_maxFileSize) {
+            break;
+        }
+        m_fileIndex++;
+    }
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        fprintf(stderr, "cannot open log file %s\n", qPrintable(m_file.fileName()));
+    }
+}
+
+void AsyncLogger::rotateIfNeeded(qint64 now)
+{
+    if (now >= m_nextDateCheck) {
+        m_fileIndex = 0;
+        openFile();
+        removeExpiredFiles();
+    } else if (m_file.isOpen() && m_file.size() >= m_maxFileSize) {
+        m_fileIndex++;
+        openFile();
+    }
+}
+
+void AsyncLogger::removeExpiredFiles()
+{
+    // 删除超过保留天数的日志文件，很多文件系统不支持创建时间，按修改时间判断
+    QDir logDir(m_directory);
+    QFileInfoList fileList = logDir.entryInfoList(QStringList() << "log_*.txt", QDir::Files);
+    QDateTime now = QDateTime::currentDateTime();
+    for (const QFileInfo &fileInfo : fileList) {
+        if (fileInfo.lastModified().daysTo(now) > m_keepDays) {
+            QFile::remove(fileInfo.absoluteFilePath());
+        }
+    }
+}
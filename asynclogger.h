@@ -0,0 +1,86 @@
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QThread>
+#include <atomic>
+
+// 异步文件日志：调用qDebug等的线程只把一行文本放入无锁队列就返回，
+// 后台线程批量写入文件；按日期和大小切换日志文件，切换时才清理过期文件
+class AsyncLogger : public QThread
+{
+public:
+    // 日志级别，低于设定级别的消息直接丢弃
+    enum Level {
+        Debug = 0,
+        Info,
+        Warning,
+        Critical,
+        Fatal
+    };
+
+    static AsyncLogger *instance();
+    ~AsyncLogger();
+
+    // 以下设置在startLogging()之前调用
+    void setDirectory(const QString &directory);
+    QString directory() const;
+    void setLevel(Level level);
+    Level level() const;
+    void setMaxFileSize(qint64 bytes);
+    void setKeepDays(int days);
+
+    // 级别名称debug/info/warning/critical，无法识别时返回defaultLevel
+    static Level levelFromName(const QString &name, Level defaultLevel = Info);
+    static Level levelOf(QtMsgType type);
+
+    bool isEnabled(Level level) const;
+
+    // 启动后台线程，之前的消息直接写到stderr
+    void startLogging();
+
+    // 可在任意线程调用，不会阻塞
+    void append(const QString &line);
+
+    // 写完队列中剩余的内容后停止后台线程，之后的消息直接写到stderr
+    void stop();
+
+protected:
+    void run() override;
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next{nullptr};
+        QByteArray data;
+    };
+
+    AsyncLogger();
+    void push(Node *node);
+    Node *pop();
+    bool drain(QByteArray *buffer);
+    void writeBuffer(QByteArray *buffer);
+    void openFile();
+    void rotateIfNeeded(qint64 now);
+    void removeExpiredFiles();
+
+    // 生产者在m_head追加，只有后台线程从m_tail取出(Vyukov MPSC队列)
+    std::atomic<Node *> m_head;
+    Node *m_tail;
+    Node m_stub;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_stopRequested{false};
+    std::atomic<int> m_level{Info};
+
+    QString m_directory;
+    qint64 m_maxFileSize = 10 * 1024 * 1024;
+    int m_keepDays = 10;
+    QFile m_file;
+    QString m_fileDate;
+    int m_fileIndex = 0;
+    qint64 m_nextDateCheck = 0;
+};
+
+#endif // ASYNCLOGGER_H
@@ -0,0 +1,116 @@
+﻿#include "baidubackend.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QUrlQuery>
+
+BaiduBackend::BaiduBackend(const QString &appId, const QString &secretKey, const QUrl &endpoint)
+    : m_appId(appId),
+      m_secretKey(secretKey),
+      m_endpoint(endpoint)
+{
+}
+
+QString BaiduBackend::name() const
+{
+    // 只显示App Id的末四位，便于区分多个账号
+    return QString(u8"百度翻译(****%1)").arg(m_appId.right(4));
+}
+
+QUrl BaiduBackend::endpoint() const
+{
+    return m_endpoint;
+}
+
+int BaiduBackend::maxBatchBytes() const
+{
+    return kBaiduMaxBatchBytes;
+}
+
+QNetworkRequest BaiduBackend::buildRequest(const QString &text, const QString &from, const QString &to,
+                                           QByteArray *body) const
+{
+    // 构建请求参数
+    QString salt = QString::number(QDateTime::currentMSecsSinceEpoch());
+    QString sign = generateSign(text, salt);
+
+    QUrlQuery query;
+    query.addQueryItem("q", text);
+    query.addQueryItem("from", from);
+    query.addQueryItem("to", to);
+    query.addQueryItem("appid", m_appId);
+    query.addQueryItem("salt", salt);
+    query.addQueryItem("sign", sign);
+    *body = query.toString(QUrl::FullyEncoded).toUtf8();
+
+    QNetworkRequest request(m_endpoint);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+    return request;
+}
+
+bool BaiduBackend::decodeReply(const QByteArray &data, QStringList *sources, QStringList *results,
+                               QString *errorCode, QString *errorMessage) const
+{
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(data, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        *errorMessage = QString(u8"JSON解析错误: %1").arg(parseError.errorString());
+        return false;
+    }
+
+    QJsonObject obj = doc.object();
+    if (obj.contains("trans_result")) {
+        QJsonArray transResult = obj["trans_result"].toArray();
+        if (transResult.isEmpty()) {
+            *errorMessage = u8"翻译结果为空";
+            return false;
+        }
+        for (const QJsonValue &value : transResult) {
+            QJsonObject segment = value.toObject();
+            sources->append(segment["src"].toString());
+            results->append(segment["dst"].toString());
+        }
+        return true;
+    }
+
+    if (obj.contains("error_code")) {
+        // 错误码有时是字符串有时是数字
+        QJsonValue code = obj["error_code"];
+        *errorCode = code.isString() ? code.toString() : QString::number(code.toInt());
+        *errorMessage = QString(u8"百度API错误: %1 - %2").arg(*errorCode, obj["error_msg"].toString());
+    } else {
+        *errorMessage = u8"未知的API响应格式";
+    }
+    return false;
+}
+
+RetryAction BaiduBackend::classifyError(const QString &errorCode) const
+{
+    // https://fanyi-api.baidu.com/doc/21 错误码列表
+    static const QHash<QString, RetryAction> actions = {
+        { "52001", RetryAction::Retry },    // 请求超时
+        { "52002", RetryAction::Retry },    // 系统错误
+        { "52003", RetryAction::FailJob },  // 未授权用户
+        { "54000", RetryAction::FailCell }, // 必填参数为空
+        { "54001", RetryAction::FailJob },  // 签名错误
+        { "54003", RetryAction::SlowDown }, // 访问频率受限
+        { "54004", RetryAction::FailJob },  // 账户余额不足
+        { "54005", RetryAction::SlowDown }, // 长query请求频繁
+        { "58000", RetryAction::FailJob },  // 客户端IP非法
+        { "58001", RetryAction::FailCell }, // 译文语言方向不支持
+        { "58002", RetryAction::FailJob },  // 服务当前已关闭
+        { "90107", RetryAction::FailJob }   // 认证未通过或未生效
+    };
+    return actions.value(errorCode, RetryAction::Retry);
+}
+
+QString BaiduBackend::generateSign(const QString &query, const QString &salt) const
+{
+    QString str = m_appId + query + salt + m_secretKey;
+    QByteArray hash = QCryptographicHash::hash(str.toUtf8(), QCryptographicHash::Md5);
+    return hash.toHex();
+}
@@ -0,0 +1,36 @@
+#ifndef BAIDUBACKEND_H
+#define BAIDUBACKEND_H
+
+#include "translationbackend.h"
+
+// 百度通用翻译接口地址，测试时可指向本地模拟服务器
+const char *const kBaiduDefaultEndpoint = "https://fanyi-api.baidu.com/api/trans/vip/translate";
+
+// 百度接口单次请求q的最大字节数
+const int kBaiduMaxBatchBytes = 6000;
+
+// 百度通用翻译API：appid+q+salt+密钥的MD5签名，按换行分段返回trans_result
+class BaiduBackend : public TranslationBackend
+{
+public:
+    BaiduBackend(const QString &appId, const QString &secretKey,
+                 const QUrl &endpoint = QUrl(QString::fromLatin1(kBaiduDefaultEndpoint)));
+
+    QString name() const override;
+    QUrl endpoint() const override;
+    int maxBatchBytes() const override;
+    QNetworkRequest buildRequest(const QString &text, const QString &from, const QString &to,
+                                 QByteArray *body) const override;
+    bool decodeReply(const QByteArray &data, QStringList *sources, QStringList *results,
+                     QString *errorCode, QString *errorMessage) const override;
+    RetryAction classifyError(const QString &errorCode) const override;
+
+private:
+    QString generateSign(const QString &query, const QString &salt) const;
+
+    QString m_appId;
+    QString m_secretKey;
+    QUrl m_endpoint;
+};
+
+#endif // BAIDUBACKEND_H
@@ -0,0 +1,18 @@
+#include "cancellationtoken.h"
+
+CancellationToken::CancellationToken(QObject *parent) : QObject(parent)
+{
+}
+
+bool CancellationToken::isCancelled() const
+{
+    return m_cancelled.load(std::memory_order_acquire);
+}
+
+void CancellationToken::cancel()
+{
+    bool expected = false;
+    if (m_cancelled.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        emit cancelled();
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef CANCELLATIONTOKEN_H
+#define CANCELLATIONTOKEN_H
+
+#include <QObject>
+#include <atomic>
+
+// 一次翻译的取消标志，由调度器和所有工作线程共享
+// isCancelled()可在任意线程无锁调用；cancelled()只发出一次，
+// 各工作线程收到后立即中止在途请求
+class CancellationToken : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CancellationToken(QObject *parent = nullptr);
+
+    bool isCancelled() const;
+
+    // 可在任意线程调用，重复调用无效果
+    void cancel();
+
+signals:
+    void cancelled();
+
+private:
+    std::atomic<bool> m_cancelled{false};
+};
+
+#endif // CANCELLATIONTOKEN_H
@@ -0,0 +1,115 @@
+﻿#include "concurrencycontroller.h"
+
+#include <QtMath>
+
+namespace {
+
+// 延迟超过参考值的倍数时认为服务器开始排队，停止增加窗口
+const double kLatencyTolerance = 2.0;
+
+// 每隔多少个样本更新一次参考延迟，网络状况变化后参考值能跟着变化
+const int kLatencyPeriod = 64;
+
+} // namespace
+
+ConcurrencyController::ConcurrencyController(int maxLimit)
+    : m_maxLimit(qMax(1, maxLimit)),
+      m_slowStartThreshold(m_maxLimit)
+{
+    m_clock.start();
+}
+
+bool ConcurrencyController::tryAcquire()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_inFlight >= qFloor(m_window)) {
+        return false;
+    }
+    m_inFlight++;
+    return true;
+}
+
+void ConcurrencyController::onSuccess(qint64 latencyMs)
+{
+    QMutexLocker locker(&m_mutex);
+    finishRequest();
+
+    if (m_periodMinLatencyMs < 0 || latencyMs < m_periodMinLatencyMs) {
+        m_periodMinLatencyMs = latencyMs;
+    }
+    if (m_baseLatencyMs < 0 || latencyMs < m_baseLatencyMs) {
+        m_baseLatencyMs = latencyMs;
+    }
+    if (++m_periodSamples >= kLatencyPeriod) {
+        m_baseLatencyMs = m_periodMinLatencyMs;
+        m_periodMinLatencyMs = -1;
+        m_periodSamples = 0;
+    }
+    m_smoothedLatencyMs = m_smoothedLatencyMs == 0 ? latencyMs : (m_smoothedLatencyMs * 7 + latencyMs) / 8;
+
+    if (latencyMs > qMax<qint64>(1, m_baseLatencyMs) * kLatencyTolerance) {
+        return;
+    }
+
+    // 慢启动阶段每次成功加1，之后每个窗口的请求全部成功才加1
+    if (m_window < m_slowStartThreshold) {
+        m_window += 1.0;
+    } else {
+        m_window += 1.0 / m_window;
+    }
+    m_window = qMin(m_window, double(m_maxLimit));
+}
+
+void ConcurrencyController::onFailure(bool congested)
+{
+    QMutexLocker locker(&m_mutex);
+    finishRequest();
+    if (!congested) {
+        return;
+    }
+
+    // 减半前已发出的请求还会陆续失败，一个延迟周期内只减一次
+    qint64 now = m_clock.elapsed();
+    if (m_lastDecreaseMs >= 0 && now - m_lastDecreaseMs < qMax<qint64>(1000, m_smoothedLatencyMs)) {
+        return;
+    }
+    m_lastDecreaseMs = now;
+    m_window = qMax(1.0, m_window / 2.0);
+    m_slowStartThreshold = m_window;
+    m_decreaseCount++;
+}
+
+void ConcurrencyController::release()
+{
+    QMutexLocker locker(&m_mutex);
+    finishRequest();
+}
+
+int ConcurrencyController::window() const
+{
+    QMutexLocker locker(&m_mutex);
+    return qFloor(m_window);
+}
+
+int ConcurrencyController::maxLimit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_maxLimit;
+}
+
+int ConcurrencyController::inFlight() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_inFlight;
+}
+
+int ConcurrencyController::decreaseCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_decreaseCount;
+}
+
+void ConcurrencyController::finishRequest()
+{
+    m_inFlight = qMax(0, m_inFlight - 1);
+}
@@ -0,0 +1,51 @@
+#ifndef CONCURRENCYCONTROLLER_H
+#define CONCURRENCYCONTROLLER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+
+// 自适应并发控制(AIMD)：延迟正常时逐步放大同时在途的请求数，
+// 遇到频率受限或超时立即减半，窗口在[1, maxLimit]之间
+// 与RateLimiter一样按账号创建，由所有工作线程共享
+class ConcurrencyController
+{
+public:
+    explicit ConcurrencyController(int maxLimit = 4);
+
+    // 窗口内还有名额时占用一个并返回true
+    bool tryAcquire();
+
+    // 请求成功返回，latencyMs为请求耗时
+    void onSuccess(qint64 latencyMs);
+
+    // 请求失败返回，congested表示服务器要求降速或请求超时
+    void onFailure(bool congested);
+
+    // 请求被取消，只归还名额，不影响窗口
+    void release();
+
+    int window() const;
+    int maxLimit() const;
+    int inFlight() const;
+    // 本次翻译中窗口被减小的次数
+    int decreaseCount() const;
+
+private:
+    void finishRequest();
+
+    mutable QMutex m_mutex;
+    int m_maxLimit;
+    double m_window = 1.0;
+    double m_slowStartThreshold;
+    int m_inFlight = 0;
+    int m_decreaseCount = 0;
+    qint64 m_baseLatencyMs = -1;    // 近期最小延迟，作为网络正常时的参考
+    qint64 m_periodMinLatencyMs = -1;
+    int m_periodSamples = 0;
+    QElapsedTimer m_clock;
+    qint64 m_lastDecreaseMs = -1;
+    qint64 m_smoothedLatencyMs = 0;
+};
+
+#endif // CONCURRENCYCONTROLLER_H
@@ -0,0 +1,231 @@
+﻿#include "csvio.h"
+
+#include <cstring>
+
+namespace {
+
+const int kWriteBufferSize = 64 * 1024;
+
+} // namespace
+
+namespace Csv {
+
+qint64 parseRecord(const char *data, qint64 size, bool atEnd, QVector<CsvFieldSpan> *fields)
+{
+    fields->clear();
+    if (size <= 0) {
+        return 0;
+    }
+
+    CsvFieldSpan field;
+    bool inQuotes = false;
+    qint64 pos = 0;
+
+    while (pos < size) {
+        if (inQuotes) {
+            // 引号内的内容直接跳到下一个引号
+            const void *quote = memchr(data + pos, '"', size_t(size - pos));
+            if (!quote) {
+                pos = size;
+                break;
+            }
+            pos = static_cast<const char *>(quote) - data;
+            if (pos + 1 >= size && !atEnd) {
+                return 0; // 还不知道后面是否紧跟另一个引号
+            }
+            if (pos + 1 < size && data[pos + 1] == '"') {
+                pos += 2; // 转义的引号
+                continue;
+            }
+            inQuotes = false;
+            ++pos;
+            continue;
+        }
+
+        char c = data[pos];
+        if (c == '"') {
+            inQuotes = true;
+            field.quoted = true;
+            ++pos;
+        } else if (c == ',') {
+            field.length = pos - field.offset;
+            fields->append(field);
+            field = CsvFieldSpan();
+            field.offset = ++pos;
+        } else if (c == '\n' || c == '\r') {
+            field.length = pos - field.offset;
+            fields->append(field);
+            qint64 end = pos + 1;
+            if (c == '\r') {
+                if (end < size) {
+                    if (data[end] == '\n') {
+                        ++end;
+                    }
+                } else if (!atEnd) {
+                    return 0; // 可能是被分块截断的\r\n
+                }
+            }
+            return end;
+        } else {
+            ++pos;
+        }
+    }
+
+    if (!atEnd) {
+        return 0;
+    }
+
+    // 文件末尾没有换行的最后一条记录
+    field.length = pos - field.offset;
+    fields->append(field);
+    return size;
+}
+
+QString decodeField(const char *data, const CsvFieldSpan &span)
+{
+    const char *begin = data + span.offset;
+    if (!span.quoted) {
+        return QString::fromUtf8(begin, int(span.length));
+    }
+
+    QByteArray unescaped;
+    unescaped.reserve(int(span.length));
+    bool inQuotes = false;
+    for (qint64 i = 0; i < span.length; ++i) {
+        char c = begin[i];
+        if (c != '"') {
+            unescaped.append(c);
+        } else if (inQuotes && i + 1 < span.length && begin[i + 1] == '"') {
+            unescaped.append('"');
+            ++i;
+        } else {
+            inQuotes = !inQuotes;
+        }
+    }
+    return QString::fromUtf8(unescaped);
+}
+
+QByteArray encodeField(const QString &field)
+{
+    QByteArray data = field.toUtf8();
+    bool needsQuotes = false;
+    for (char c : data) {
+        if (c == ',' || c == '"' || c == '\n' || c == '\r') {
+            needsQuotes = true;
+            break;
+        }
+    }
+    if (!needsQuotes) {
+        return data;
+    }
+
+    QByteArray quoted;
+    quoted.reserve(data.size() + 2);
+    quoted.append('"');
+    for (char c : data) {
+        if (c == '"') {
+            quoted.append('"');
+        }
+        quoted.append(c);
+    }
+    quoted.append('"');
+    return quoted;
+}
+
+} // namespace Csv
+
+CsvReader::CsvReader(QIODevice *device, int chunkSize)
+    : m_device(device),
+      m_chunkSize(qMax(1024, chunkSize))
+{
+}
+
+bool CsvReader::readRow(QStringList *row)
+{
+    for (;;) {
+        const char *data = m_buffer.constData() + m_pos;
+        qint64 available = m_buffer.size() - m_pos;
+        qint64 consumed = Csv::parseRecord(data, available, m_eof, &m_fields);
+        if (consumed > 0) {
+            row->clear();
+            row->reserve(m_fields.size());
+            for (const CsvFieldSpan &field : m_fields) {
+                row->append(Csv::decodeField(data, field));
+            }
+            m_pos += consumed;
+            return true;
+        }
+
+        if (m_eof || !fill()) {
+            return false;
+        }
+    }
+}
+
+bool CsvReader::fill()
+{
+    // 丢弃已经解析过的数据，只保留未完成的记录
+    if (m_pos > 0) {
+        m_buffer.remove(0, int(m_pos));
+        m_pos = 0;
+    }
+
+    QByteArray chunk = m_device->read(m_chunkSize);
+    if (chunk.isEmpty()) {
+        m_eof = true;
+        return !m_buffer.isEmpty();
+    }
+
+    // 跳过UTF-8 BOM
+    if (!m_started) {
+        m_started = true;
+        if (chunk.startsWith("\xEF\xBB\xBF")) {
+            chunk.remove(0, 3);
+        }
+    }
+
+    m_buffer.append(chunk);
+    return true;
+}
+
+CsvWriter::CsvWriter(QIODevice *device)
+    : m_device(device)
+{
+    m_buffer.reserve(kWriteBufferSize);
+}
+
+CsvWriter::~CsvWriter()
+{
+    flush();
+}
+
+void CsvWriter::writeRow(const QStringList &row)
+{
+    for (int i = 0; i < row.size(); ++i) {
+        if (i > 0) {
+            m_buffer.append(',');
+        }
+        m_buffer.append(Csv::encodeField(row[i]));
+    }
+    m_buffer.append('\n');
+
+    if (m_buffer.size() >= kWriteBufferSize) {
+        flush();
+    }
+}
+
+bool CsvWriter::flush()
+{
+    if (!m_buffer.isEmpty()) {
+        if (m_device->write(m_buffer) != m_buffer.size()) {
+            m_error = true;
+        }
+        m_buffer.resize(0); // 保留已分配的容量
+    }
+    return !m_error;
+}
+
+bool CsvWriter::hasError() const
+{
+    return m_error;
+}
@@ -0,0 +1,72 @@
+#ifndef CSVIO_H
+#define CSVIO_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// 一个字段在缓冲区中的原始字节范围（包含引号）
+struct CsvFieldSpan
+{
+    qint64 offset = 0;
+    qint64 length = 0;
+    bool quoted = false; // 字段中出现过引号，需要还原转义
+};
+
+// RFC 4180 CSV解析/编码的底层函数，直接在UTF-8字节缓冲区上工作
+namespace Csv {
+
+// 从data[0, size)解析一条记录，字段位置相对于data。
+// 成功返回消耗的字节数（包含行尾换行）；数据不足以构成完整记录且atEnd为false时返回0，
+// 调用方应补充数据后从同一位置重新解析
+qint64 parseRecord(const char *data, qint64 size, bool atEnd, QVector<CsvFieldSpan> *fields);
+
+// 将字段还原为文本（去掉包围的引号，""还原为"）
+QString decodeField(const char *data, const CsvFieldSpan &span);
+
+// 将字段编码为CSV格式的UTF-8字节，必要时加引号并转义
+QByteArray encodeField(const QString &field);
+
+} // namespace Csv
+
+// 分块读取的CSV读取器，内存占用只与单条记录大小有关，可处理超过内存的文件
+class CsvReader
+{
+public:
+    explicit CsvReader(QIODevice *device, int chunkSize = 64 * 1024);
+
+    // 读取下一行，没有更多数据时返回false
+    bool readRow(QStringList *row);
+
+private:
+    bool fill();
+
+    QIODevice *m_device;
+    int m_chunkSize;
+    QByteArray m_buffer;
+    qint64 m_pos = 0;
+    bool m_eof = false;
+    bool m_started = false;
+    QVector<CsvFieldSpan> m_fields;
+};
+
+// 带缓冲的CSV写入器，正确转义包含逗号、引号和换行的字段
+class CsvWriter
+{
+public:
+    explicit CsvWriter(QIODevice *device);
+    ~CsvWriter();
+
+    void writeRow(const QStringList &row);
+    bool flush();
+    bool hasError() const;
+
+private:
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    bool m_error = false;
+};
+
+#endif // CSVIO_H
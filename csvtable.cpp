@@ -0,0 +1,312 @@
+﻿#include "csvtable.h"
+#include "csvio.h"
+
+#include <QFileInfo>
+
+#include <cstring>
+
+CsvTable::CsvTable()
+{
+}
+
+CsvTable::~CsvTable()
+{
+    clear();
+}
+
+bool CsvTable::load(const QString &filePath, QString *errorMessage)
+{
+    clear();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = m_file.errorString();
+        }
+        return false;
+    }
+    m_filePath = filePath;
+
+    qint64 size = m_file.size();
+    if (size == 0) {
+        return true;
+    }
+
+    uchar *mapped = m_file.map(0, size);
+    if (!mapped) {
+        if (errorMessage) {
+            *errorMessage = m_file.errorString();
+        }
+        clear();
+        return false;
+    }
+    m_data = reinterpret_cast<const char *>(mapped);
+
+    // 跳过UTF-8 BOM
+    qint64 pos = 0;
+    if (size >= 3 && memcmp(m_data, "\xEF\xBB\xBF", 3) == 0) {
+        pos = 3;
+    }
+
+    // 第一条记录作为表头，其余记录逐列记录字段范围
+    QVector<CsvFieldSpan> fields;
+    bool headerParsed = false;
+    while (pos < size) {
+        qint64 consumed = Csv::parseRecord(m_data + pos, size - pos, true, &fields);
+        if (consumed <= 0) {
+            break;
+        }
+
+        if (!headerParsed) {
+            for (const CsvFieldSpan &field : fields) {
+                CsvFieldSpan span = field;
+                span.offset += pos;
+                appendColumn(Csv::decodeField(m_data, span), 0);
+            }
+            headerParsed = true;
+        } else {
+            // 比表头更长的行补充无名列
+            while (m_columns.size() < fields.size()) {
+                appendColumn(QString(), m_rowCount);
+            }
+            for (int col = 0; col < m_columns.size(); ++col) {
+                Cell cell;
+                if (col < fields.size()) {
+                    cell.offset = pos + fields[col].offset;
+                    cell.length = qint32(fields[col].length);
+                    cell.mapped = true;
+                    cell.quoted = fields[col].quoted;
+                }
+                m_columns[col].cells.append(cell);
+            }
+            m_rowCount++;
+        }
+        pos += consumed;
+    }
+
+    return true;
+}
+
+bool CsvTable::save(const QString &filePath, QString *errorMessage)
+{
+    // 覆盖正在映射的源文件前先把单元格内容全部取出
+    if (m_data && QFileInfo(filePath).absoluteFilePath() == QFileInfo(m_filePath).absoluteFilePath()) {
+        detachFromFile();
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+
+    CsvWriter writer(&file);
+    writer.writeRow(headers());
+    for (int row = 0; row < m_rowCount; ++row) {
+        writer.writeRow(this->row(row));
+    }
+
+    if (!writer.flush()) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+void CsvTable::clear()
+{
+    if (m_data) {
+        m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_data)));
+        m_data = nullptr;
+    }
+    m_file.close();
+    m_filePath.clear();
+    m_rowCount = 0;
+    m_columns.clear();
+}
+
+bool CsvTable::isEmpty() const
+{
+    return m_columns.isEmpty();
+}
+
+QString CsvTable::filePath() const
+{
+    return m_filePath;
+}
+
+int CsvTable::rowCount() const
+{
+    return m_rowCount;
+}
+
+int CsvTable::columnCount() const
+{
+    return m_columns.size();
+}
+
+QStringList CsvTable::headers() const
+{
+    QStringList result;
+    result.reserve(m_columns.size());
+    for (const Column &column : m_columns) {
+        result.append(column.header);
+    }
+    return result;
+}
+
+QString CsvTable::header(int column) const
+{
+    if (column < 0 || column >= m_columns.size()) {
+        return QString();
+    }
+    return m_columns[column].header;
+}
+
+int CsvTable::columnIndex(const QString &name) const
+{
+    for (int col = 0; col < m_columns.size(); ++col) {
+        if (m_columns[col].header == name) {
+            return col;
+        }
+    }
+    return -1;
+}
+
+int CsvTable::addColumn(const QString &name)
+{
+    appendColumn(name, m_rowCount);
+    return m_columns.size() - 1;
+}
+
+QString CsvTable::cell(int row, int column) const
+{
+    if (row < 0 || row >= m_rowCount || column < 0 || column >= m_columns.size()) {
+        return QString();
+    }
+
+    const Column &col = m_columns[column];
+    const Cell &cell = col.cells[row];
+    if (cell.mapped) {
+        CsvFieldSpan span;
+        span.offset = cell.offset;
+        span.length = cell.length;
+        span.quoted = cell.quoted;
+        return Csv::decodeField(m_data, span);
+    }
+    return col.pool.mid(int(cell.offset), cell.length);
+}
+
+bool CsvTable::isCellEmpty(int row, int column) const
+{
+    if (row < 0 || row >= m_rowCount || column < 0 || column >= m_columns.size()) {
+        return true;
+    }
+
+    const Column &col = m_columns[column];
+    const Cell &cell = col.cells[row];
+    if (cell.length == 0) {
+        return true;
+    }
+
+    // 不含引号的映射字段直接检查原始字节，避免解码
+    if (cell.mapped && !cell.quoted) {
+        const char *begin = m_data + cell.offset;
+        for (qint32 i = 0; i < cell.length; ++i) {
+            char c = begin[i];
+            if (c != ' ' && c != '\t') {
+                return false;
+            }
+        }
+        return true;
+    }
+    return cell.mapped ? this->cell(row, column).trimmed().isEmpty()
+                       : QStringRef(&col.pool, int(cell.offset), cell.length).trimmed().isEmpty();
+}
+
+void CsvTable::setCell(int row, int column, const QString &text)
+{
+    if (row < 0 || row >= m_rowCount || column < 0 || column >= m_columns.size()) {
+        return;
+    }
+
+    Column &col = m_columns[column];
+    Cell &cell = col.cells[row];
+    cell.offset = col.pool.size();
+    cell.length = text.size();
+    cell.mapped = false;
+    cell.quoted = false;
+    col.pool.append(text);
+}
+
+QStringList CsvTable::column(int column) const
+{
+    QStringList result;
+    if (column < 0 || column >= m_columns.size()) {
+        return result;
+    }
+
+    result.reserve(m_rowCount);
+    for (int row = 0; row < m_rowCount; ++row) {
+        result.append(cell(row, column));
+    }
+    return result;
+}
+
+QStringList CsvTable::row(int row) const
+{
+    QStringList result;
+    result.reserve(m_columns.size());
+    for (int col = 0; col < m_columns.size(); ++col) {
+        result.append(cell(row, col));
+    }
+    return result;
+}
+
+QHash<QString, QBitArray> CsvTable::translatedRows(const QStringList &languages) const
+{
+    // 只检查单元格是否为空，不解码也不复制译文
+    QHash<QString, QBitArray> result;
+    for (const QString &language : languages) {
+        int column = columnIndex(language);
+        if (column == -1) {
+            continue;
+        }
+        QBitArray rows(m_rowCount);
+        for (int row = 0; row < m_rowCount; ++row) {
+            if (!isCellEmpty(row, column)) {
+                rows.setBit(row);
+            }
+        }
+        result.insert(language, rows);
+    }
+    return result;
+}
+
+void CsvTable::appendColumn(const QString &name, int rows)
+{
+    Column column;
+    column.header = name;
+    column.cells.resize(rows);
+    m_columns.append(column);
+}
+
+void CsvTable::detachFromFile()
+{
+    // 把仍指向映射区的单元格复制到文本池后解除映射
+    for (int column = 0; column < m_columns.size(); ++column) {
+        for (int row = 0; row < m_rowCount; ++row) {
+            if (m_columns[column].cells[row].mapped) {
+                setCell(row, column, cell(row, column));
+            }
+        }
+    }
+
+    m_file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(m_data)));
+    m_data = nullptr;
+    m_file.close();
+}
@@ -0,0 +1,70 @@
+#ifndef CSVTABLE_H
+#define CSVTABLE_H
+
+#include <QBitArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// 按列存储的CSV表格
+// 源文件通过内存映射读取，未修改的单元格只记录其在映射区中的字节范围，访问时才解码；
+// 修改过的单元格和新增的翻译列写入所在列的连续文本池中
+class CsvTable
+{
+public:
+    CsvTable();
+    ~CsvTable();
+
+    bool load(const QString &filePath, QString *errorMessage = nullptr);
+    bool save(const QString &filePath, QString *errorMessage = nullptr);
+    void clear();
+
+    bool isEmpty() const;
+    QString filePath() const;
+    int rowCount() const;
+    int columnCount() const;
+
+    QStringList headers() const;
+    QString header(int column) const;
+    int columnIndex(const QString &name) const;
+    int addColumn(const QString &name);
+
+    QString cell(int row, int column) const;
+    bool isCellEmpty(int row, int column) const;
+    void setCell(int row, int column, const QString &text);
+    QStringList column(int column) const;
+    QStringList row(int row) const;
+
+    // 按语言列名标记已有译文的行(每行一位)，供翻译时跳过已翻译的单元格
+    // 不存在的语言列没有对应项
+    QHash<QString, QBitArray> translatedRows(const QStringList &languages) const;
+
+private:
+    struct Cell
+    {
+        qint64 offset = 0;
+        qint32 length = 0;
+        bool mapped = false; // true: 映射区中的原始字段字节；false: 文本池中的UTF-16字符
+        bool quoted = false;
+    };
+
+    struct Column
+    {
+        QString header;
+        QVector<Cell> cells;
+        QString pool;
+    };
+
+    void appendColumn(const QString &name, int rows);
+    void detachFromFile();
+
+    QString m_filePath;
+    QFile m_file;
+    const char *m_data = nullptr;
+    int m_rowCount = 0;
+    QVector<Column> m_columns;
+};
+
+#endif // CSVTABLE_H
@@ -0,0 +1,169 @@
+﻿#include "csvtablemodel.h"
+
+#include <QColor>
+#include <QFont>
+
+namespace {
+
+// 待审核单元格的背景色
+const QColor kReviewColor(255, 243, 205);
+
+qint64 cellKey(int row, int column)
+{
+    return (qint64(row) << 32) | quint32(column);
+}
+
+} // namespace
+
+CsvTableModel::CsvTableModel(CsvTable *table, QObject *parent)
+    : QAbstractTableModel(parent),
+      m_table(table)
+{
+}
+
+void CsvTableModel::setHeaderNames(const QMap<QString, QString> &headerNames)
+{
+    m_headerNames = headerNames;
+    if (columnCount() > 0) {
+        emit headerDataChanged(Qt::Horizontal, 0, columnCount() - 1);
+    }
+}
+
+void CsvTableModel::reload()
+{
+    beginResetModel();
+    m_reviewCells.clear();
+    endResetModel();
+}
+
+int CsvTableModel::ensureColumn(const QString &name)
+{
+    int column = m_table->columnIndex(name);
+    if (column != -1) {
+        return column;
+    }
+
+    column = m_table->columnCount();
+    beginInsertColumns(QModelIndex(), column, column);
+    m_table->addColumn(name);
+    endInsertColumns();
+    return column;
+}
+
+void CsvTableModel::setCell(int row, int column, const QString &text)
+{
+    m_table->setCell(row, column, text);
+    QModelIndex changed = index(row + 1, column);
+    emit dataChanged(changed, changed, { Qt::DisplayRole, Qt::EditRole });
+}
+
+void CsvTableModel::cellsChanged(int firstRow, int lastRow, int column)
+{
+    emit dataChanged(index(firstRow + 1, column), index(lastRow + 1, column), { Qt::DisplayRole, Qt::EditRole });
+}
+
+void CsvTableModel::markForReview(int row, int column)
+{
+    m_reviewCells.insert(cellKey(row, column));
+    QModelIndex changed = index(row + 1, column);
+    emit dataChanged(changed, changed, { Qt::BackgroundRole, Qt::ToolTipRole });
+}
+
+void CsvTableModel::clearReviewMarks()
+{
+    if (m_reviewCells.isEmpty()) {
+        return;
+    }
+    m_reviewCells.clear();
+    if (rowCount() > 1 && columnCount() > 0) {
+        emit dataChanged(index(1, 0), index(rowCount() - 1, columnCount() - 1), { Qt::BackgroundRole, Qt::ToolTipRole });
+    }
+}
+
+int CsvTableModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid() || m_table->isEmpty()) {
+        return 0;
+    }
+    return m_table->rowCount() + 1;
+}
+
+int CsvTableModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_table->columnCount();
+}
+
+QVariant CsvTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid()) {
+        return QVariant();
+    }
+
+    bool headerRow = (index.row() == 0);
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::EditRole:
+        return headerRow ? m_table->header(index.column()) : m_table->cell(index.row() - 1, index.column());
+    case Qt::FontRole:
+        if (headerRow) {
+            QFont font;
+            font.setBold(true);
+            return font;
+        }
+        break;
+    case Qt::BackgroundRole:
+        if (headerRow) {
+            return QColor(240, 240, 240);
+        }
+        if (m_reviewCells.contains(cellKey(index.row() - 1, index.column()))) {
+            return kReviewColor;
+        }
+        break;
+    case Qt::ToolTipRole:
+        if (!headerRow && m_reviewCells.contains(cellKey(index.row() - 1, index.column()))) {
+            return QString(u8"译文来自翻译记忆库中的相似原文，请审核");
+        }
+        break;
+    default:
+        break;
+    }
+    return QVariant();
+}
+
+QVariant CsvTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    if (orientation == Qt::Vertical) {
+        return section + 1;
+    }
+
+    // 检查是否为支持的语言代码，如果是则显示中文名称
+    QString header = m_table->header(section);
+    return m_headerNames.value(header, header);
+}
+
+Qt::ItemFlags CsvTableModel::flags(const QModelIndex &index) const
+{
+    Qt::ItemFlags itemFlags = QAbstractTableModel::flags(index);
+    if (index.isValid() && index.row() > 0) {
+        itemFlags |= Qt::ItemIsEditable;
+    }
+    return itemFlags;
+}
+
+bool CsvTableModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || index.row() == 0 || role != Qt::EditRole) {
+        return false;
+    }
+
+    m_reviewCells.remove(cellKey(index.row() - 1, index.column()));
+    setCell(index.row() - 1, index.column(), value.toString());
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef CSVTABLEMODEL_H
+#define CSVTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QMap>
+#include <QSet>
+#include "csvtable.h"
+
+// 预览界面使用的表格模型，直接读取CsvTable，不复制单元格
+// 第0行显示原始表头（只读），其余行对应数据行
+class CsvTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit CsvTableModel(CsvTable *table, QObject *parent = nullptr);
+
+    // 表头中的语言代码显示为中文名称
+    void setHeaderNames(const QMap<QString, QString> &headerNames);
+
+    // 重新加载CsvTable后调用
+    void reload();
+
+    // 查找目标语言列，不存在时添加
+    int ensureColumn(const QString &name);
+
+    // 修改数据行（不含表头行）的单元格，只通知这一个单元格变化
+    void setCell(int row, int column, const QString &text);
+
+    // CsvTable中数据行[firstRow, lastRow]的某一列已被直接修改
+    void cellsChanged(int firstRow, int lastRow, int column);
+
+    // 标记需要人工审核的单元格，手工修改后或重新加载时取消标记
+    void markForReview(int row, int column);
+    void clearReviewMarks();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+
+private:
+    CsvTable *m_table;
+    QMap<QString, QString> m_headerNames;
+    QSet<qint64> m_reviewCells; // 数据行号 << 32 | 列号
+};
+
+#endif // CSVTABLEMODEL_H
@@ -0,0 +1,216 @@
+﻿#include "fuzzyindex.h"
+
+#include <QRegularExpression>
+#include <QSet>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 不在占位符编号{0}中的连续数字
+const QRegularExpression &numberPattern()
+{
+    static const QRegularExpression pattern(QStringLiteral("(?<![{\\d])\\d+(?![}\\d])"));
+    return pattern;
+}
+
+QStringList numbersIn(const QString &text)
+{
+    QStringList numbers;
+    QRegularExpressionMatchIterator it = numberPattern().globalMatch(text);
+    while (it.hasNext()) {
+        numbers.append(it.next().captured());
+    }
+    return numbers;
+}
+
+} // namespace
+
+QString FuzzyIndex::canonicalText(const QString &text)
+{
+    QString result;
+    result.reserve(text.size());
+    bool pendingSpace = false;
+    bool lastDigit = false;
+    for (const QChar &c : text) {
+        if (c.isDigit()) {
+            if (!lastDigit) {
+                if (pendingSpace && !result.isEmpty()) {
+                    result += QLatin1Char(' ');
+                }
+                result += QLatin1Char('#');
+            }
+            pendingSpace = false;
+            lastDigit = true;
+        } else if (c.isLetter() || c.isMark()) {
+            if (pendingSpace && !result.isEmpty()) {
+                result += QLatin1Char(' ');
+            }
+            result += c.toLower();
+            pendingSpace = false;
+            lastDigit = false;
+        } else {
+            // 空白和标点都当作分隔
+            pendingSpace = true;
+            lastDigit = false;
+        }
+    }
+    return result;
+}
+
+QString FuzzyIndex::transferNumbers(const QString &translation, const QString &matchedSource, const QString &source)
+{
+    const QStringList from = numbersIn(matchedSource);
+    const QStringList to = numbersIn(source);
+    if (from.isEmpty() || from == to || from.size() != to.size()) {
+        return translation;
+    }
+
+    QVector<QRegularExpressionMatch> matches;
+    QRegularExpressionMatchIterator it = numberPattern().globalMatch(translation);
+    while (it.hasNext()) {
+        matches.append(it.next());
+    }
+    if (matches.size() != from.size()) {
+        return translation;
+    }
+    for (int i = 0; i < matches.size(); ++i) {
+        if (matches[i].captured() != from[i]) {
+            return translation;
+        }
+    }
+
+    QString result;
+    int last = 0;
+    for (int i = 0; i < matches.size(); ++i) {
+        result += translation.midRef(last, matches[i].capturedStart() - last);
+        result += to[i];
+        last = matches[i].capturedEnd();
+    }
+    result += translation.midRef(last);
+    return result;
+}
+
+QVector<quint64> FuzzyIndex::grams(const QString &text)
+{
+    // 首尾补空格，短文本也至少有一个三元组
+    const QString padded = QLatin1Char(' ') + canonicalText(text) + QLatin1Char(' ');
+    QVector<quint64> result;
+    if (padded.size() < 3) {
+        return result;
+    }
+    result.reserve(padded.size() - 2);
+    for (int i = 0; i + 2 < padded.size(); ++i) {
+        result.append((quint64(padded[i].unicode()) << 32) | (quint64(padded[i + 1].unicode()) << 16)
+                      | quint64(padded[i + 2].unicode()));
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+int FuzzyIndex::add(const QString &text)
+{
+    const int id = m_texts.size();
+    const QVector<quint64> textGrams = grams(text);
+    m_texts.append(text);
+    m_textBytes += text.size() * qint64(sizeof(QChar));
+    if (m_gramOffsets.isEmpty()) {
+        m_gramOffsets.append(0);
+    }
+    m_grams += textGrams;
+    m_gramOffsets.append(m_grams.size());
+    for (quint64 gram : textGrams) {
+        m_postings[gram].append(id);
+    }
+    return id;
+}
+
+FuzzyIndex::Match FuzzyIndex::find(const QString &text, double threshold) const
+{
+    Match best;
+    const QVector<quint64> query = grams(text);
+    if (query.isEmpty() || threshold <= 0.0) {
+        return best;
+    }
+
+    // 从最稀有的三元组开始，不在索引中的排在最前
+    QVector<QPair<int, quint64>> order;
+    order.reserve(query.size());
+    for (quint64 gram : query) {
+        QHash<quint64, QVector<int>>::const_iterator it = m_postings.constFind(gram);
+        order.append(qMakePair(it == m_postings.constEnd() ? 0 : it->size(), gram));
+    }
+    std::sort(order.begin(), order.end());
+
+    const int querySize = query.size();
+    const int minOverlap = int(std::ceil(threshold * querySize - 1e-9));
+    const int prefixLength = querySize - minOverlap + 1;
+    const int minSize = int(std::ceil(threshold * querySize - 1e-9));
+    const int maxSize = int(std::floor(querySize / threshold + 1e-9));
+
+    QSet<int> checked;
+    for (int i = 0; i < prefixLength && i < order.size(); ++i) {
+        QHash<quint64, QVector<int>>::const_iterator postings = m_postings.constFind(order[i].second);
+        if (postings == m_postings.constEnd()) {
+            continue;
+        }
+        for (int id : *postings) {
+            const quint64 *candidateBegin = m_grams.constData() + m_gramOffsets[id];
+            const quint64 *candidateEnd = m_grams.constData() + m_gramOffsets[id + 1];
+            const int candidateSize = int(candidateEnd - candidateBegin);
+            if (candidateSize < minSize || candidateSize > maxSize || checked.contains(id)) {
+                continue;
+            }
+            checked.insert(id);
+
+            // 两个有序数组求交集大小
+            int overlap = 0;
+            QVector<quint64>::const_iterator a = query.constBegin();
+            const quint64 *b = candidateBegin;
+            while (a != query.constEnd() && b != candidateEnd) {
+                if (*a < *b) {
+                    ++a;
+                } else if (*b < *a) {
+                    ++b;
+                } else {
+                    ++overlap;
+                    ++a;
+                    ++b;
+                }
+            }
+            const double similarity = double(overlap) / double(querySize + candidateSize - overlap);
+            if (similarity >= threshold && similarity > best.similarity) {
+                best.id = id;
+                best.similarity = similarity;
+                if (overlap == querySize && overlap == candidateSize) {
+                    return best;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+QString FuzzyIndex::text(int id) const
+{
+    return m_texts.value(id);
+}
+
+int FuzzyIndex::size() const
+{
+    return m_texts.size();
+}
+
+qint64 FuzzyIndex::memoryBytes() const
+{
+    // 按Qt容器的布局估算：QString/QVector各有约24字节的头，QHash每个节点约32字节
+    const qint64 containerHeader = 24;
+    const qint64 hashNode = 32;
+    qint64 bytes = m_textBytes + m_texts.size() * (containerHeader + qint64(sizeof(void *)));
+    bytes += m_grams.capacity() * qint64(sizeof(quint64)) + m_gramOffsets.capacity() * qint64(sizeof(int));
+    for (QHash<quint64, QVector<int>>::const_iterator it = m_postings.constBegin(); it != m_postings.constEnd(); ++it) {
+        bytes += hashNode + containerHeader + it->capacity() * qint64(sizeof(int));
+    }
+    return bytes;
+}
@@ -0,0 +1,53 @@
+#ifndef FUZZYINDEX_H
+#define FUZZYINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// 相似原文的内存索引：字符三元组倒排表 + 前缀过滤
+// 比较前先转为小写，数字统一为#，去掉标点并合并空白，只有数字或标点不同的文本视为相同；
+// 查询时按倒排表从短到长取三元组，Jaccard相似度不低于阈值的记录必然包含前|q|-⌈t|q|⌉+1个中的至少一个，
+// 只需验证这些倒排表中长度合适的记录。不是线程安全的，由调用者加锁
+// 内存：一条规范形式为L个字符的原文约有L个三元组，保存原文2L字节、三元组8L字节、倒排表4L字节，
+// 加上每条记录和每个三元组的固定开销，见memoryBytes()
+class FuzzyIndex
+{
+public:
+    struct Match
+    {
+        int id = -1;
+        double similarity = 0.0;
+    };
+
+    // 比较用的规范形式
+    static QString canonicalText(const QString &text);
+
+    // 原文与匹配原文只有数字不同时，把译文中对应的数字替换成原文的数字
+    // 译文中的数字与匹配原文顺序不一致时无法确定对应关系，返回原译文
+    static QString transferNumbers(const QString &translation, const QString &matchedSource, const QString &source);
+
+    // 添加一条原文，返回其编号
+    int add(const QString &text);
+
+    // 返回相似度最高且不低于threshold的记录，没有时id为-1
+    Match find(const QString &text, double threshold) const;
+
+    QString text(int id) const;
+    int size() const;
+
+    // 索引占用内存的估计值(字节)
+    qint64 memoryBytes() const;
+
+private:
+    static QVector<quint64> grams(const QString &text);
+
+    QStringList m_texts;
+    QVector<quint64> m_grams;                 // 各记录排序去重后的三元组依次连在一起，不为每条记录单独分配
+    QVector<int> m_gramOffsets;               // 第id条记录的三元组为m_grams[m_gramOffsets[id], m_gramOffsets[id + 1])
+    QHash<quint64, QVector<int>> m_postings;  // 三元组 -> 包含它的记录编号(递增)
+    qint64 m_textBytes = 0;
+};
+
+#endif // FUZZYINDEX_H
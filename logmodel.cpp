@@ -0,0 +1,167 @@
+﻿#include "logmodel.h"
+
+#include <QBrush>
+#include <QColor>
+#include <QDateTime>
+
+namespace {
+
+// 待插入的消息攒够这么多时立即插入，不等定时器
+const int kMaxPending = 2000;
+
+} // namespace
+
+LogModel::LogModel(int capacity, QObject *parent) : QAbstractListModel(parent),
+    m_capacity(qMax(100, capacity)),
+    m_flushTimer(new QTimer(this))
+{
+    m_entries.resize(m_capacity);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(100);
+    connect(m_flushTimer, &QTimer::timeout, this, &LogModel::flush);
+}
+
+void LogModel::append(AsyncLogger::Level level, const QString &text)
+{
+    LogEntry entry;
+    entry.time = QTime::currentTime().toString("hh:mm:ss");
+    entry.level = level;
+    entry.text = text;
+    m_pending.append(entry);
+
+    if (m_pending.size() >= kMaxPending) {
+        flush();
+    } else if (!m_flushTimer->isActive()) {
+        m_flushTimer->start();
+    }
+}
+
+void LogModel::clear()
+{
+    m_flushTimer->stop();
+    beginResetModel();
+    m_pending.clear();
+    m_first = 0;
+    m_count = 0;
+    endResetModel();
+}
+
+int LogModel::capacity() const
+{
+    return m_capacity;
+}
+
+AsyncLogger::Level LogModel::classify(const QString &text)
+{
+    // qDebug转发来的消息带有级别前缀
+    if (text.contains(" Critical: ") || text.contains(" Fatal: ")) {
+        return AsyncLogger::Critical;
+    }
+    if (text.contains(" Warning: ")) {
+        return AsyncLogger::Warning;
+    }
+    if (text.contains(" Debug: ")) {
+        return AsyncLogger::Debug;
+    }
+
+    if (text.startsWith(u8"翻译错误") || text.startsWith(u8"错误") || text.startsWith(u8"翻译失败")) {
+        return AsyncLogger::Critical;
+    }
+    if (text.contains(u8"失败") || text.contains(u8"错误") || text.contains(u8"超时") || text.contains(u8"警告")) {
+        return AsyncLogger::Warning;
+    }
+    return AsyncLogger::Info;
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_count;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_count) {
+        return QVariant();
+    }
+
+    const LogEntry &entry = entryAt(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+        return QString("[%1] %2").arg(entry.time, entry.text);
+    case Qt::ToolTipRole:
+        return entry.text;
+    case Qt::ForegroundRole:
+        if (entry.level >= AsyncLogger::Critical) {
+            return QBrush(QColor("#ff6b6b"));
+        } else if (entry.level == AsyncLogger::Warning) {
+            return QBrush(QColor("#f0ad4e"));
+        } else if (entry.level == AsyncLogger::Debug) {
+            return QBrush(QColor("#888888"));
+        }
+        return QVariant();
+    case LevelRole:
+        return int(entry.level);
+    default:
+        return QVariant();
+    }
+}
+
+void LogModel::flush()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+
+    // 一批消息比容量还多时只保留最后的部分
+    if (m_pending.size() > m_capacity) {
+        m_pending.remove(0, m_pending.size() - m_capacity);
+    }
+
+    // 先删掉放不下的最早的行，再一次性插入
+    int overflow = m_count + m_pending.size() - m_capacity;
+    if (overflow > 0) {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        m_first = (m_first + overflow) % m_capacity;
+        m_count -= overflow;
+        endRemoveRows();
+    }
+
+    beginInsertRows(QModelIndex(), m_count, m_count + m_pending.size() - 1);
+    for (const LogEntry &entry : m_pending) {
+        m_entries[(m_first + m_count) % m_capacity] = entry;
+        m_count++;
+    }
+    endInsertRows();
+    m_pending.clear();
+    emit flushed();
+}
+
+const LogEntry &LogModel::entryAt(int row) const
+{
+    return m_entries[(m_first + row) % m_capacity];
+}
+
+LogFilterModel::LogFilterModel(QObject *parent) : QSortFilterProxyModel(parent)
+{
+}
+
+void LogFilterModel::setMinimumLevel(AsyncLogger::Level level)
+{
+    m_minimumLevel = level;
+    invalidateFilter();
+}
+
+void LogFilterModel::setKeyword(const QString &keyword)
+{
+    m_keyword = keyword.trimmed();
+    invalidateFilter();
+}
+
+bool LogFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    QModelIndex index = sourceModel()->index(sourceRow, 0, sourceParent);
+    if (index.data(LogModel::LevelRole).toInt() < m_minimumLevel) {
+        return false;
+    }
+    return m_keyword.isEmpty() || index.data(Qt::ToolTipRole).toString().contains(m_keyword, Qt::CaseInsensitive);
+}
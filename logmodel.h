@@ -0,0 +1,79 @@
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QSortFilterProxyModel>
+#include <QTimer>
+#include <QVector>
+#include "asynclogger.h"
+
+// 界面日志的一行
+struct LogEntry
+{
+    QString time;
+    AsyncLogger::Level level = AsyncLogger::Info;
+    QString text;
+};
+
+// 界面日志模型：固定容量的环形缓冲，超出容量时丢弃最早的行；
+// 新消息先放入待插入列表，定时一次性插入，视图每批只更新一次
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit LogModel(int capacity = 5000, QObject *parent = nullptr);
+
+    // 追加一条消息，最迟100毫秒后显示
+    void append(AsyncLogger::Level level, const QString &text);
+    void clear();
+
+    int capacity() const;
+
+    // 根据消息内容推断级别，用于没有显式级别的日志
+    static AsyncLogger::Level classify(const QString &text);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // data()中返回日志级别的角色
+    static const int LevelRole = Qt::UserRole + 1;
+
+signals:
+    // 一批消息插入完成
+    void flushed();
+
+private slots:
+    void flush();
+
+private:
+    const LogEntry &entryAt(int row) const;
+
+    int m_capacity;
+    QVector<LogEntry> m_entries; // 环形缓冲，m_first为最早一行
+    int m_first = 0;
+    int m_count = 0;
+    QVector<LogEntry> m_pending;
+    QTimer *m_flushTimer;
+};
+
+// 按级别和关键字(如语言代码)筛选日志
+class LogFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    explicit LogFilterModel(QObject *parent = nullptr);
+
+    void setMinimumLevel(AsyncLogger::Level level);
+    void setKeyword(const QString &keyword);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    AsyncLogger::Level m_minimumLevel = AsyncLogger::Debug;
+    QString m_keyword;
+};
+
+#endif // LOGMODEL_H
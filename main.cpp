@@ -8,14 +8,28 @@
 #include <QSslConfiguration>
 #include <QLibraryInfo>
 #include <QFile>
+#include <QSettings>
 #include <QIcon> // 添加QIcon头文件
+#include <QTimer>
 #include "appobject.h"
+#include "asynclogger.h"
+#include "translationcli.h"
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <cstdio>
+#endif
 
 #define INSTANCE_LOCK_PATH ".spark-godot-translation"
 
 void customMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
 {
     Q_UNUSED(context)
+    AsyncLogger *logger = AsyncLogger::instance();
+    if (type != QtFatalMsg && !logger->isEnabled(AsyncLogger::levelOf(type))) {
+        return;
+    }
+
     QString txt;
     QString timestampS = QDateTime::currentDateTime().toString("yyyy_MM_dd_hh:mm:ss");
     switch (type) {
@@ -37,53 +51,77 @@ void customMessageHandler(QtMsgType type, const QMessageLogContext &context, con
     }
     emit app->sigDebug(txt);
 
-    QString timestamp = QDateTime::currentDateTime().toString("yyyy_MM_dd");
-#ifdef Q_OS_LINUX
-    QString logFolder = QDir::homePath() + "/"+INSTANCE_LOCK_PATH +"/log";
-    QDir().mkpath(logFolder); // 创建log文件夹
+    // 写文件由后台线程完成，这里只入队；程序即将中止时先把队列写完
+    logger->append(txt);
+    if (type == QtFatalMsg) {
+        logger->stop();
+    }
+}
 
-    QString logFileName = QString("%1/log/log_%2.txt").arg(QDir::homePath() + "/"+INSTANCE_LOCK_PATH ).arg(timestamp);
+// 启动后台日志线程，级别和单个文件大小可在config.ini中设置
+void setupLogging()
+{
+#ifdef Q_OS_LINUX
+    QString logFolder = QDir::homePath() + "/" + INSTANCE_LOCK_PATH + "/log";
 #else
-    QString logFolder = "log";
-    QDir().mkpath(logFolder); // 创建log文件夹
-
-    QString logFileName = QString("%1/log/log_%2.txt").arg(QCoreApplication::applicationDirPath()).arg(timestamp);
+    QString logFolder = QCoreApplication::applicationDirPath() + "/log";
 #endif
-    QFile outFile(logFileName);
-    outFile.open(QIODevice::WriteOnly | QIODevice::Append);
-    QTextStream textStream(&outFile);
-    textStream << txt << endl;
-
-    // 删除10天前的日志文件
-    QDir logDir(logFolder);
-    QStringList filters;
-    filters << "log_*.txt";
-    logDir.setNameFilters(filters);
-
-    QFileInfoList fileList = logDir.entryInfoList();
-    for (QFileInfo fileInfo: fileList) {
-        QDateTime fileTime = fileInfo.birthTime();
-        if (fileTime.daysTo(QDateTime::currentDateTime()) > 10) {
-            QFile::remove(fileInfo.absoluteFilePath());
-        }
+    QSettings settings("config.ini", QSettings::IniFormat);
+    AsyncLogger *logger = AsyncLogger::instance();
+    logger->setDirectory(logFolder);
+    logger->setLevel(AsyncLogger::levelFromName(settings.value("settings/logLevel", "info").toString()));
+    logger->setMaxFileSize(settings.value("settings/logMaxSizeMB", 10).toLongLong() * 1024 * 1024);
+    logger->setKeepDays(10);
+    logger->startLogging();
+    qInstallMessageHandler(customMessageHandler);
+}
+
+// 设置应用程序信息
+void setupApplicationInfo()
+{
+    QCoreApplication::setApplicationName("Spark Godot Translation");
+    QCoreApplication::setApplicationVersion("1.0.0");
+    QCoreApplication::setOrganizationName("Spark Studio");
+    QCoreApplication::setOrganizationDomain("spark-studio.com");
+
+    // 设置UTF-8编码
+    QTextCodec::setCodecForLocale(QTextCodec::codecForName("UTF-8"));
+}
+
+// 命令行批处理模式，不创建QApplication和任何窗口
+int runCli(int argc, char *argv[])
+{
+#ifdef Q_OS_WIN
+    // 程序以WIN32子系统构建，需要挂到启动它的控制台上才能输出
+    if (AttachConsole(ATTACH_PARENT_PROCESS)) {
+        freopen("CONOUT$", "w", stdout);
+        freopen("CONOUT$", "w", stderr);
     }
+#endif
+
+    QCoreApplication a(argc, argv);
+    setupLogging();
+    setupApplicationInfo();
+
+    TranslationCli cli;
+    QTimer::singleShot(0, &cli, &TranslationCli::run);
+    int exitCode = a.exec();
+    AsyncLogger::instance()->stop();
+    return exitCode;
 }
 
 int main(int argc, char *argv[])
 {
+    if (TranslationCli::isRequested(argc, argv)) {
+        return runCli(argc, argv);
+    }
+
     QApplication a(argc, argv);
  
-     qInstallMessageHandler(customMessageHandler);
+     setupLogging();
      a.setWindowIcon(QIcon(":/icon.png")); // 设置应用程序图标
 
-    // 设置应用程序信息
-    QApplication::setApplicationName("Spark Godot Translation");
-    QApplication::setApplicationVersion("1.0.0");
-    QApplication::setOrganizationName("Spark Studio");
-    QApplication::setOrganizationDomain("spark-studio.com");
-
-    // 设置UTF-8编码
-    QTextCodec::setCodecForLocale(QTextCodec::codecForName("UTF-8"));
+    setupApplicationInfo();
 
     // 加载QSS样式表
     QFile styleFile(":/styles.qss");
@@ -101,12 +139,12 @@ int main(int argc, char *argv[])
     w.show();
 
 
-    // 详细的SSL诊断信息
-    qDebug() << u8"Qt版本:" << QT_VERSION_STR;
-    qDebug() << u8"Qt库路径:" << QLibraryInfo::location(QLibraryInfo::LibrariesPath);
-    qDebug() << u8"OpenSSL构建版本:" << QSslSocket::sslLibraryBuildVersionString();
-    qDebug() << u8"OpenSSL运行时版本:" << QSslSocket::sslLibraryVersionString();
-    qDebug() << u8"OpenSSL支持情况:" << QSslSocket::supportsSsl();
+    // 详细的SSL诊断信息，默认的info级别下也记录到日志文件
+    qInfo() << u8"Qt版本:" << QT_VERSION_STR;
+    qInfo() << u8"Qt库路径:" << QLibraryInfo::location(QLibraryInfo::LibrariesPath);
+    qInfo() << u8"OpenSSL构建版本:" << QSslSocket::sslLibraryBuildVersionString();
+    qInfo() << u8"OpenSSL运行时版本:" << QSslSocket::sslLibraryVersionString();
+    qInfo() << u8"OpenSSL支持情况:" << QSslSocket::supportsSsl();
     
     if (!QSslSocket::supportsSsl()) {
         qWarning() << u8"警告: OpenSSL不可用，HTTPS请求可能失败";
@@ -123,5 +161,7 @@ int main(int argc, char *argv[])
         qDebug() << u8"已设置默认SSL配置";
     }
     
-    return a.exec();
+    int exitCode = a.exec();
+    AsyncLogger::instance()->stop();
+    return exitCode;
 }
@@ -2,21 +2,51 @@
 #include "ui_mainwindow.h"
 #include "translationworker.h"
 
+namespace {
+
+// 百度翻译开放平台各版本的QPS上限
+struct AccountTier
+{
+    const char *key;
+    const char *name;
+    double qps;
+    int burst;
+};
+
+const AccountTier kAccountTiers[] = {
+    { "standard", u8"标准版(1次/秒)", 1.0, 1 },
+    { "advanced", u8"高级版(10次/秒)", 10.0, 10 },
+    { "premium", u8"尊享版(100次/秒)", 100.0, 100 },
+};
+
+} // namespace
+
 // MainWindow 实现
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow),
     m_settings(nullptr),
-    m_translationThread(nullptr),
-    m_translationWorker(nullptr),
+    m_scheduler(nullptr),
+    m_previewModel(nullptr),
     m_isTranslating(false),
     m_totalTranslations(0),
     m_currentTranslation(0)
 {
     ui->setupUi(this);
+    // 日志视图要在加载设置之前建好，加载上次的CSV文件时就会输出日志
+    m_settings = new QSettings("config.ini", QSettings::IniFormat, this);
     initializeUI();
+    setupLogView();
+    setupMetricsView();
     loadSettings();
     setupLanguageCheckboxes();
+
+    // 翻译记忆库在多次翻译之间共享，首次使用时才加载
+    QString memoryPath = m_settings->value("settings/memoryPath", TranslationMemory::defaultFilePath()).toString();
+    m_translationMemory.reset(new TranslationMemory(memoryPath));
+
+    // 启动时在后台建立到翻译接口的连接，第一次翻译不必等待握手
+    warmUpConnections();
     
     // 启用拖拽
     setAcceptDrops(true);
@@ -33,13 +63,8 @@ MainWindow::MainWindow(QWidget *parent) :
 
 MainWindow::~MainWindow()
 {
-    if (m_translationThread && m_translationThread->isRunning()) {
-        if (m_translationWorker) {
-            m_translationWorker->stopTranslation();
-        }
-        m_translationThread->quit();
-        m_translationThread->wait(3000);
-    }
+    // 调度器析构时停止并等待所有工作线程
+    delete m_scheduler;
     
     delete m_settings;
     delete ui;
@@ -78,6 +103,20 @@ void MainWindow::initializeUI()
     m_supportedLanguages["hu"] = u8"匈牙利语";
     m_supportedLanguages["vie"] = u8"越南语";
     
+    // 初始化百度翻译账号类型
+    for (const AccountTier &preset : kAccountTiers) {
+        ui->comboBox_tier->addItem(QString::fromUtf8(preset.name), preset.key);
+    }
+    ui->comboBox_tier->addItem(u8"自定义", "custom");
+
+    // 初始化预览表格，行高固定，视图只绘制可见的行
+    m_previewModel = new CsvTableModel(&m_table, this);
+    m_previewModel->setHeaderNames(m_supportedLanguages);
+    ui->table_previewData->setModel(m_previewModel);
+    ui->table_previewData->setAlternatingRowColors(true);
+    ui->table_previewData->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui->table_previewData->verticalHeader()->setDefaultSectionSize(ui->table_previewData->fontMetrics().height() + 8);
+    
     // 设置窗口标题
     setWindowTitle(u8"星火Godot 翻译工具");
     
@@ -93,8 +132,6 @@ void MainWindow::initializeUI()
 
 void MainWindow::loadSettings()
 {
-    m_settings = new QSettings("config.ini", QSettings::IniFormat, this);
-    
     // 加载API配置
     ui->edit_id->setText(m_settings->value("api/appId", "").toString());
     ui->edit_key->setText(m_settings->value("api/secretKey", "").toString());
@@ -114,9 +151,18 @@ void MainWindow::loadSettings()
         loadCSVFile(lastFilePath);
     }
     
-    // 加载延迟时间设置
-    int delayTime = m_settings->value("settings/delayTime", 100).toInt();
-    ui->edit_delay->setText(QString::number(delayTime));
+    // 加载限速设置
+    QString tier = m_settings->value("settings/accountTier", "standard").toString();
+    int tierIndex = ui->comboBox_tier->findData(tier);
+    ui->comboBox_tier->setCurrentIndex(tierIndex == -1 ? 0 : tierIndex);
+    on_comboBox_tier_currentIndexChanged(ui->comboBox_tier->currentIndex());
+    if (tier == "custom") {
+        ui->spinBox_qps->setValue(m_settings->value("settings/qps", 1.0).toDouble());
+        ui->spinBox_burst->setValue(m_settings->value("settings/burst", 1).toInt());
+    }
+
+    // 加载并发请求数设置
+    ui->spinBox_concurrency->setValue(m_settings->value("settings/maxConcurrent", 4).toInt());
 }
 
 void MainWindow::saveSettings()
@@ -134,11 +180,13 @@ void MainWindow::saveSettings()
     // 保存文件路径
     m_settings->setValue("file/lastPath", ui->edit_filePath->text());
     
-    // 保存延迟时间设置
-    if(ui->edit_delay->text().toInt() > 0)
-    {
-        m_settings->setValue("settings/delayTime", ui->edit_delay->text().toInt());
-    }
+    // 保存限速设置
+    m_settings->setValue("settings/accountTier", ui->comboBox_tier->currentData().toString());
+    m_settings->setValue("settings/qps", ui->spinBox_qps->value());
+    m_settings->setValue("settings/burst", ui->spinBox_burst->value());
+
+    // 保存并发请求数设置
+    m_settings->setValue("settings/maxConcurrent", ui->spinBox_concurrency->value());
     
     m_settings->sync();
 }
@@ -194,36 +242,84 @@ void MainWindow::loadCSVFile(const QString &filePath)
         return;
     }
     
-    try {
-        m_csvData = parseCSV(filePath);
-        if (!m_csvData.isEmpty()) {
-            m_csvHeaders = m_csvData.first();
-            updateSourceLanguageCombo();
-            updatePreviewTable();
-            addLogMessage(QString(u8"成功加载CSV文件: %1 行数据").arg(m_csvData.size() - 1));
-        }
-    } catch (const std::exception &e) {
-        addLogMessage(u8"加载CSV文件失败: " + QString::fromStdString(e.what()));
+    QString errorMessage;
+    bool loaded = m_table.load(filePath, &errorMessage);
+    updatePreviewTable();
+    if (!loaded) {
+        addLogMessage(u8"加载CSV文件失败: " + errorMessage);
+        return;
+    }
+    
+    if (!m_table.isEmpty()) {
+        updateSourceLanguageCombo();
+        addLogMessage(QString(u8"成功加载CSV文件: %1 行数据").arg(m_table.rowCount()));
     }
 }
 
 void MainWindow::updateSourceLanguageCombo()
 {
     ui->comboBox_originLang->clear();
-    if (!m_csvHeaders.isEmpty()) {
-        ui->comboBox_originLang->addItems(m_csvHeaders);
+    if (!m_table.isEmpty()) {
+        ui->comboBox_originLang->addItems(m_table.headers());
     }
 }
 
+void MainWindow::setupLogView()
+{
+    // 日志列表只保留最近的若干行，视图只绘制可见的行
+    m_logModel = new LogModel(m_settings->value("settings/logCapacity", 5000).toInt(), this);
+    m_logFilter = new LogFilterModel(this);
+    m_logFilter->setSourceModel(m_logModel);
+    ui->listViewLog->setModel(m_logFilter);
+
+    ui->comboBox_logLevel->addItem(u8"全部日志", int(AsyncLogger::Debug));
+    ui->comboBox_logLevel->addItem(u8"警告及错误", int(AsyncLogger::Warning));
+    ui->comboBox_logLevel->addItem(u8"仅错误", int(AsyncLogger::Critical));
+    connect(ui->comboBox_logLevel, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int index) {
+        m_logFilter->setMinimumLevel(AsyncLogger::Level(ui->comboBox_logLevel->itemData(index).toInt()));
+    });
+    connect(ui->edit_logFilter, &QLineEdit::textChanged, m_logFilter, &LogFilterModel::setKeyword);
+
+    connect(m_logModel, &LogModel::rowsAboutToBeInserted, this, [this]() {
+        QScrollBar *scrollBar = ui->listViewLog->verticalScrollBar();
+        m_logFollowTail = scrollBar->value() >= scrollBar->maximum();
+    });
+    connect(m_logModel, &LogModel::flushed, this, [this]() {
+        if (m_logFollowTail) {
+            ui->listViewLog->scrollToBottom();
+        }
+    });
+}
+
+void MainWindow::setupMetricsView()
+{
+    // 统计面板可见时每秒刷新一次，切换到其他页时不刷新
+    m_metricsModel = new MetricsModel(this);
+    ui->tableViewMetrics->setModel(m_metricsModel);
+    ui->tableViewMetrics->verticalHeader()->setVisible(false);
+    ui->tableViewMetrics->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    ui->tableViewMetrics->horizontalHeader()->setStretchLastSection(true);
+
+    m_metricsTimer = new QTimer(this);
+    m_metricsTimer->setInterval(1000);
+    connect(m_metricsTimer, &QTimer::timeout, m_metricsModel, &MetricsModel::refresh);
+    connect(ui->tabWidget, &QTabWidget::currentChanged, this, [this](int) {
+        if (ui->tabWidget->currentWidget() == ui->tab_metrics) {
+            m_metricsModel->refresh();
+            m_metricsTimer->start();
+        } else {
+            m_metricsTimer->stop();
+        }
+    });
+}
+
 void MainWindow::addLogMessage(const QString &message)
 {
-    QString timestamp = QDateTime::currentDateTime().toString("hh:mm:ss");
-    ui->textEditLog->append(QString("[%1] %2").arg(timestamp, message));
-    
-    // 自动滚动到底部
-    QTextCursor cursor = ui->textEditLog->textCursor();
-    cursor.movePosition(QTextCursor::End);
-    ui->textEditLog->setTextCursor(cursor);
+    // 消息先进入日志模型的待插入列表，每100毫秒批量显示一次
+    if (!m_logModel) {
+        return;
+    }
+    m_logModel->append(LogModel::classify(message), message);
 }
 
 void MainWindow::updateProgress(int value, const QString &text)
@@ -252,75 +348,35 @@ QStringList MainWindow::getSelectedTargetLanguages()
     return selectedLangs;
 }
 
-void MainWindow::selectAllLanguages(bool select)
+void MainWindow::warmUpConnections()
 {
-    for (QCheckBox *checkbox : m_languageCheckboxes) {
-        checkbox->setChecked(select);
+    TranslationAccount primaryAccount;
+    primaryAccount.endpoint = QUrl(m_settings->value("api/endpoint").toString());
+    QVector<TranslationAccount> accounts = TranslationBackend::loadAccounts(m_settings);
+    accounts.prepend(primaryAccount);
+
+    QList<QUrl> endpoints;
+    for (const TranslationAccount &account : accounts) {
+        QSharedPointer<TranslationBackend> backend = TranslationBackend::create(account);
+        if (backend && !endpoints.contains(backend->endpoint())) {
+            endpoints.append(backend->endpoint());
+        }
     }
+    NetworkSessionPool::instance()->warmUp(endpoints);
 }
 
-QList<QStringList> MainWindow::parseCSV(const QString &filePath)
+void MainWindow::selectAllLanguages(bool select)
 {
-    QList<QStringList> data;
-    QFile file(filePath);
-    
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        throw std::runtime_error(u8"无法打开文件");
-    }
-    
-    QTextStream in(&file);
-    in.setCodec("UTF-8");
-    
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        QStringList fields;
-        
-        // 简单的CSV解析（支持引号包围的字段）
-        bool inQuotes = false;
-        QString currentField;
-        
-        for (int i = 0; i < line.length(); ++i) {
-            QChar c = line[i];
-            
-            if (c == '"') {
-                inQuotes = !inQuotes;
-            } else if (c == ',' && !inQuotes) {
-                fields.append(currentField);
-                currentField.clear();
-            } else {
-                currentField.append(c);
-            }
-        }
-        
-        fields.append(currentField);
-        data.append(fields);
+    for (QCheckBox *checkbox : m_languageCheckboxes) {
+        checkbox->setChecked(select);
     }
-    
-    return data;
 }
 
-void MainWindow::saveCSV(const QString &filePath, const QList<QStringList> &data)
+void MainWindow::saveCSV(const QString &filePath)
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        throw std::runtime_error(u8"无法创建文件");
-    }
-    
-    QTextStream out(&file);
-    out.setCodec("UTF-8");
-    
-    for (const QStringList &row : data) {
-        QStringList escapedRow;
-        for (const QString &field : row) {
-            QString escapedField = field;
-            if (field.contains(',') || field.contains('"') || field.contains('\n')) {
-                escapedField = '"' + field;
-                escapedField.replace('"', "\"\"");
-                escapedField += '"';
-            }
-            escapedRow.append(escapedField);
-        }
-        out << escapedRow.join(',') << '\n';
+    QString errorMessage;
+    if (!m_table.save(filePath, &errorMessage)) {
+        throw std::runtime_error(errorMessage.toStdString());
     }
 }
 
@@ -406,7 +462,7 @@ void MainWindow::on_btn_cancelSelect_clicked()
 
 void MainWindow::on_btn_clearLog_clicked()
 {
-    ui->textEditLog->clear();
+    m_logModel->clear();
 }
 
 void MainWindow::on_btn_start_clicked()
@@ -421,7 +477,7 @@ void MainWindow::on_btn_start_clicked()
     }
     
     // 检查CSV文件
-    if (m_csvData.isEmpty()) {
+    if (m_table.isEmpty()) {
         QMessageBox::warning(this, u8"警告", u8"请先加载CSV文件");
         return;
     }
@@ -441,127 +497,224 @@ void MainWindow::on_btn_start_clicked()
     }
     
     // 获取源文本
-    int sourceColumnIndex = m_csvHeaders.indexOf(sourceColumn);
+    int sourceColumnIndex = m_table.columnIndex(sourceColumn);
     if (sourceColumnIndex == -1) {
         QMessageBox::warning(this, u8"警告", u8"源语言列不存在");
         return;
     }
     
-    QStringList sourceTexts;
-    for (int i = 1; i < m_csvData.size(); ++i) { // 跳过标题行
-        if (sourceColumnIndex < m_csvData[i].size()) {
-            sourceTexts.append(m_csvData[i][sourceColumnIndex]);
-        } else {
-            sourceTexts.append("");
-        }
+    QStringList sourceTexts = m_table.column(sourceColumnIndex);
+    m_sourceColumnIndex = sourceColumnIndex;
+
+    // 读取上次保存的翻译清单，原文修改过的行需要重新翻译
+    QString manifestError;
+    if (!m_manifest.load(TranslationManifest::pathFor(m_table.filePath()), &manifestError)) {
+        addLogMessage(u8"无法读取翻译清单，将只按译文是否为空判断: " + manifestError);
     }
     
+    // 打开翻译日志，上次中断的翻译可以从中恢复
+    QHash<QString, QBitArray> resumedRows;
+    QVector<TranslationReview> resumedReviews;
+    openJournal(sourceColumn, &resumedRows, &resumedReviews);
+    
     // 设置UI状态
     m_isTranslating = true;
     ui->btn_start->setEnabled(false);
     ui->btn_stop->setEnabled(true);
     ui->progressBar->setValue(0);
+    ui->progressBar->setFormat("%p%");
     
-    // 创建翻译线程
-    m_translationThread = new QThread(this);
-    m_translationWorker = new TranslationWorker();
-    m_translationWorker->moveToThread(m_translationThread);
-    
-    // 收集已翻译的数据
-    QHash<QString, QHash<int, QString>> existingTranslations;
-    for (const QString &targetLang : targetLangs) {
-        int targetColumnIndex = m_csvHeaders.indexOf(targetLang);
-        if (targetColumnIndex != -1) {
-            QHash<int, QString> langTranslations;
-            for (int i = 1; i < m_csvData.size(); ++i) { // 跳过标题行
-                if (targetColumnIndex < m_csvData[i].size()) {
-                    langTranslations[i-1] = m_csvData[i][targetColumnIndex]; // i-1因为sourceTexts跳过了标题行
-                }
-            }
-            existingTranslations[targetLang] = langTranslations;
-        }
-    }
+    // 创建翻译调度器，工作线程在开始翻译时创建
+    delete m_scheduler;
+    m_scheduler = new TranslationScheduler(this);
+    m_failures.clear();
+    m_reviews.clear();
+    m_previewModel->clearReviewMarks();
     
     // 设置翻译配置
-    m_translationWorker->setConfig(appId, secretKey);
-    m_translationWorker->setTranslationData(sourceTexts, "auto", targetLangs, ui->checkbox_tsed->isChecked());
-    m_translationWorker->setExistingTranslations(existingTranslations);
-    
-    // 设置延迟时间
-    int delayTime = m_settings->value("settings/delayTime", 50).toInt();
-    m_translationWorker->setDelayTime(delayTime);
+    // 强制重新翻译时也跳过本次任务日志中已完成的单元格
+    bool forceRetranslate = ui->checkbox_tsed->isChecked();
+    m_scheduler->setTranslationData(sourceTexts, "auto", targetLangs, false);
+    if (forceRetranslate) {
+        m_scheduler->setTranslatedRows(resumedRows);
+    } else {
+        int staleCount = 0;
+        int reviewCount = 0;
+        m_scheduler->setTranslatedRows(m_manifest.upToDateRows(m_table, sourceColumnIndex, targetLangs,
+                                                               &staleCount, &reviewCount));
+        if (staleCount > 0) {
+            addLogMessage(QString(u8"原文已修改，%1个单元格的译文将重新翻译").arg(staleCount));
+        }
+        if (reviewCount > 0) {
+            addLogMessage(QString(u8"%1个单元格仍是未经审核的相似译文，将重新翻译").arg(reviewCount));
+        }
+    }
+    // 从日志恢复的相似译文本次不再重新翻译，计算完需要翻译的行之后再标为待审核
+    applyReviews(resumedReviews);
+    
+    // 界面中的账号使用界面上的限速设置，config.ini的accounts中可配置更多账号分担请求
+    TranslationAccount primaryAccount;
+    primaryAccount.appId = appId;
+    primaryAccount.secretKey = secretKey;
+    primaryAccount.endpoint = QUrl(m_settings->value("api/endpoint").toString());
+    primaryAccount.qps = ui->spinBox_qps->value();
+    primaryAccount.burst = ui->spinBox_burst->value();
+    QVector<TranslationAccount> accounts;
+    accounts.append(primaryAccount);
+    accounts += TranslationBackend::loadAccounts(m_settings);
+    for (const TranslationAccount &account : accounts) {
+        QSharedPointer<TranslationBackend> backend = TranslationBackend::create(account);
+        if (!backend) {
+            addLogMessage(QString(u8"不支持的翻译接口: %1").arg(account.provider));
+            continue;
+        }
+        // 每个账号一个令牌桶，由该账号的所有在途请求共享
+        m_scheduler->addBackend(backend, QSharedPointer<RateLimiter>(new RateLimiter(account.qps, account.burst)));
+    }
+    m_scheduler->setTranslationMemory(m_translationMemory);
+    m_scheduler->setMaxConcurrent(ui->spinBox_concurrency->value());
+    m_settings->setValue("settings/maxConcurrent", ui->spinBox_concurrency->value());
+
+    // 批量请求的字节上限，0表示不合并请求
+    m_scheduler->setMaxBatchBytes(m_settings->value("settings/batchBytes", kDefaultMaxBatchBytes).toInt());
+
+    // 工作线程数，0表示按目标语言数自动决定
+    m_scheduler->setWorkerCount(m_settings->value("settings/workerThreads", 0).toInt());
+
+    // 临时错误的最大重试次数，超过后该单元格记入失败列表
+    m_scheduler->setRetryPolicy(RetryPolicy(m_settings->value("settings/maxRetries", 5).toInt()));
+
+    // 翻译记忆库相似匹配的阈值，默认0只使用完全相同的原文；相似译文不经请求直接写入，需要在config.ini中显式开启
+    m_scheduler->setFuzzyThreshold(m_settings->value("settings/fuzzyThreshold", 0.0).toDouble());
     
     // 连接信号
-    connect(m_translationThread, &QThread::started, m_translationWorker, &TranslationWorker::startTranslation);
-    connect(m_translationWorker, &TranslationWorker::progressUpdated, this, &MainWindow::onTranslationProgress);
-    connect(m_translationWorker, &TranslationWorker::translationFinished, this, &MainWindow::onTranslationFinished);
-    connect(m_translationWorker, &TranslationWorker::translationError, this, &MainWindow::onTranslationError);
-    connect(m_translationWorker, &TranslationWorker::logMessage, this, &MainWindow::onLogMessage);
+    connect(m_scheduler, &TranslationScheduler::progressUpdated, this, &MainWindow::onTranslationProgress);
+    connect(m_scheduler, &TranslationScheduler::translationFinished, this, &MainWindow::onTranslationFinished);
+    connect(m_scheduler, &TranslationScheduler::translationStopped, this, &MainWindow::onTranslationStopped);
+    connect(m_scheduler, &TranslationScheduler::translationError, this, &MainWindow::onTranslationError);
+    connect(m_scheduler, &TranslationScheduler::logMessage, this, &MainWindow::onLogMessage);
     
     // 启动翻译
-    m_translationThread->start();
     addLogMessage(u8"开始翻译...");
+    m_scheduler->startTranslation();
 }
 
 void MainWindow::on_btn_stop_clicked()
 {
-    if (m_translationWorker) {
-        m_translationWorker->stopTranslation();
-        addLogMessage(u8"正在停止翻译...");
+    if (!m_scheduler || !m_isTranslating) {
+        resetTranslationButtons();
+        return;
     }
-    ui->btn_start->setEnabled(true);
+
+    // 工作线程交回已完成的结果并回收后才允许重新开始
+    addLogMessage(u8"正在停止翻译...");
     ui->btn_stop->setEnabled(false);
+    m_scheduler->stopTranslation();
 }
 
-// 翻译进度回调
-void MainWindow::onTranslationProgress(int current, int total, const QString &currentText, const QString &translatedText, const QString &targetLang)
+void MainWindow::onTranslationStopped()
 {
-    int progress = (current * 100) / total;
-    ui->progressBar->setValue(progress);
-    
-    addLogMessage(QString("[%1] %2 -> %3").arg(targetLang, currentText.left(50), translatedText.left(50)));
-    
-    // 更新CSV数据
-    QString targetColumnName = targetLang;
-    int targetColumnIndex = m_csvHeaders.indexOf(targetColumnName);
-    
-    // 如果目标语言列不存在，添加它
-    if (targetColumnIndex == -1) {
-        m_csvHeaders.append(targetColumnName);
-        targetColumnIndex = m_csvHeaders.size() - 1;
-        
-        // 为所有行添加新列
-        for (int i = 0; i < m_csvData.size(); ++i) {
-            while (m_csvData[i].size() <= targetColumnIndex) {
-                if (i == 0) {
-                    // 第一行是标题行，添加语言代码
-                    m_csvData[i].append(targetColumnName);
-                } else {
-                    // 其他行添加空字符串
-                    m_csvData[i].append("");
-                }
+    resetTranslationButtons();
+    if (m_journal) {
+        m_journal->sync();
+        addLogMessage(u8"已完成的翻译已记录到翻译日志，再次开始翻译时可以继续");
+    }
+}
+
+void MainWindow::applyTranslationResults(const QVector<TranslationResult> &results)
+{
+    // 写入一批结果，按列记录涉及的行范围，每列只通知视图一次
+    QHash<QString, int> columnByLang;
+    QMap<int, QPair<int, int>> changedRows;
+    for (const TranslationResult &result : results) {
+        QHash<QString, int>::const_iterator it = columnByLang.constFind(result.targetLang);
+        int targetColumnIndex;
+        if (it != columnByLang.constEnd()) {
+            targetColumnIndex = it.value();
+        } else {
+            // 目标语言列不存在时添加它
+            int columnCount = m_table.columnCount();
+            targetColumnIndex = m_previewModel->ensureColumn(result.targetLang);
+            if (targetColumnIndex == columnCount) {
+                resizePreviewColumns(targetColumnIndex, targetColumnIndex);
             }
+            columnByLang.insert(result.targetLang, targetColumnIndex);
+        }
+        
+        m_table.setCell(result.row, targetColumnIndex, result.text);
+        m_manifest.record(m_table.cell(result.row, 0), result.targetLang,
+                          TranslationManifest::sourceHash(m_table.cell(result.row, m_sourceColumnIndex)));
+        
+        QMap<int, QPair<int, int>>::iterator range = changedRows.find(targetColumnIndex);
+        if (range == changedRows.end()) {
+            changedRows.insert(targetColumnIndex, qMakePair(result.row, result.row));
+        } else {
+            range->first = qMin(range->first, result.row);
+            range->second = qMax(range->second, result.row);
         }
     }
     
-    // 更新翻译结果（计算在数据中的实际行索引）
-    int dataRowIndex = ((current - 1) % (m_csvData.size() - 1)) + 1;
-    if (dataRowIndex < m_csvData.size() && targetColumnIndex < m_csvData[dataRowIndex].size()) {
-        m_csvData[dataRowIndex][targetColumnIndex] = translatedText;
-        // 更新预览表格显示
-        updatePreviewTable();
+    for (QMap<int, QPair<int, int>>::const_iterator it = changedRows.constBegin(); it != changedRows.constEnd(); ++it) {
+        m_previewModel->cellsChanged(it.value().first, it.value().second, it.key());
     }
 }
 
+// 标出使用相似原文译文的单元格，必须在对应的结果写入表格之后调用
+// 清单中记为待审核，覆盖applyTranslationResults中的记录，下次翻译时译文未经修改的单元格仍会重新翻译
+void MainWindow::applyReviews(const QVector<TranslationReview> &reviews)
+{
+    for (const TranslationReview &review : reviews) {
+        int column = m_table.columnIndex(review.targetLang);
+        m_previewModel->markForReview(review.row, column);
+        m_manifest.recordForReview(m_table.cell(review.row, 0), review.targetLang,
+                                   TranslationManifest::sourceHash(m_table.cell(review.row, m_sourceColumnIndex)),
+                                   TranslationManifest::sourceHash(m_table.cell(review.row, column)));
+    }
+    m_reviews += reviews;
+}
+
+// 翻译进度回调，工作线程每100毫秒汇总发送一批结果
+void MainWindow::onTranslationProgress(const TranslationProgress &progress)
+{
+    QElapsedTimer applyTimer;
+    applyTimer.start();
+    applyTranslationResults(progress.results);
+    static MetricHistogram *const uiUpdateMetric = MetricsRegistry::instance()->histogram(kMetricUiUpdateDuration);
+    uiUpdateMetric->observe(applyTimer.nsecsElapsed() / 1000000.0);
+    if (m_journal) {
+        m_journal->append(progress.results, progress.reviews);
+    }
+    m_failures += progress.failures;
+    applyReviews(progress.reviews);
+    
+    // 进度、速度和预计剩余时间显示在进度条上
+    if (progress.total > 0) {
+        ui->progressBar->setValue(int(qint64(progress.completed) * 100 / progress.total));
+    }
+    
+    double seconds = progress.elapsedMs / 1000.0;
+    double cellsPerSecond = seconds > 0 ? progress.completed / seconds : 0;
+    QString remainingText = "--:--:--";
+    if (cellsPerSecond > 0) {
+        qint64 remaining = qint64((progress.total - progress.completed) / cellsPerSecond);
+        remainingText = QString("%1:%2:%3").arg(remaining / 3600, 2, 10, QChar('0'))
+                                          .arg(remaining / 60 % 60, 2, 10, QChar('0'))
+                                          .arg(remaining % 60, 2, 10, QChar('0'));
+    }
+    ui->progressBar->setFormat(QString(u8"%p%  %1/%2  %3条/秒  已请求%4次  并发%5  剩余 %6")
+                               .arg(progress.completed).arg(progress.total)
+                               .arg(cellsPerSecond, 0, 'f', 1)
+                               .arg(progress.requestCount)
+                               .arg(progress.concurrencyWindow)
+                               .arg(remainingText));
+}
+
 void MainWindow::onTranslationFinished()
 {
     resetTranslationButtons();
     ui->progressBar->setValue(100);
     addLogMessage(u8"翻译完成！");
     
-    // 更新预览表格显示最终结果
-    updatePreviewTable();
-    
     // 保存翻译结果
     QString originalFilePath = ui->edit_filePath->text();
     QString outputFilePath = originalFilePath;
@@ -569,31 +722,75 @@ void MainWindow::onTranslationFinished()
     outputFilePath.replace(u8".csv", QString(u8"_%1.csv").arg(timestamp));
     
     try {
-        saveCSV(outputFilePath, m_csvData);
+        saveCSV(outputFilePath);
         addLogMessage(u8"翻译结果已保存到: " + outputFilePath);
-        QMessageBox::information(this, u8"完成", u8"翻译完成！\n结果已保存到: " + outputFilePath);
+        
+        // 结果已保存，不再需要翻译日志
+        if (m_journal) {
+            m_journal->remove();
+            m_journal.reset();
+        }
+
+        // 清单保存在源文件旁和结果文件旁：结果复制回项目文件后再次翻译时读取的是源文件旁的清单，
+        // 只处理原文修改过或缺少译文的行
+        QStringList manifestPaths;
+        manifestPaths << TranslationManifest::pathFor(m_table.filePath()) << TranslationManifest::pathFor(outputFilePath);
+        manifestPaths.removeDuplicates();
+        for (const QString &manifestPath : manifestPaths) {
+            QString manifestError;
+            if (!m_manifest.save(manifestPath, &manifestError)) {
+                addLogMessage(u8"保存翻译清单失败: " + manifestPath + " " + manifestError);
+            }
+        }
+
+        // 多次重试仍失败的单元格另存一份，修正后可以只补翻这些内容
+        QString failureMessage;
+        if (!m_failures.isEmpty()) {
+            QString failureFilePath = outputFilePath;
+            failureFilePath.replace(u8".csv", QString(u8"_failed.csv"));
+            QString errorMessage;
+            if (TranslationScheduler::saveFailures(failureFilePath, m_failures, m_table.column(0), &errorMessage)) {
+                failureMessage = QString(u8"\n%1个单元格翻译失败，列表已保存到: %2").arg(m_failures.size()).arg(failureFilePath);
+            } else {
+                failureMessage = QString(u8"\n%1个单元格翻译失败，保存失败列表出错: %2").arg(m_failures.size()).arg(errorMessage);
+            }
+            addLogMessage(failureMessage.mid(1));
+        }
+
+        // 使用相似原文译文的单元格在预览中已高亮，另存一份列表供审核
+        if (!m_reviews.isEmpty()) {
+            QString reviewFilePath = outputFilePath;
+            reviewFilePath.replace(u8".csv", QString(u8"_review.csv"));
+            QString errorMessage;
+            QString reviewMessage;
+            if (TranslationScheduler::saveReviews(reviewFilePath, m_reviews, m_table.column(0), &errorMessage)) {
+                reviewMessage = QString(u8"\n%1个单元格使用了相似原文的译文，待审核列表已保存到: %2").arg(m_reviews.size()).arg(reviewFilePath);
+            } else {
+                reviewMessage = QString(u8"\n%1个单元格使用了相似原文的译文，保存待审核列表出错: %2").arg(m_reviews.size()).arg(errorMessage);
+            }
+            addLogMessage(reviewMessage.mid(1));
+            failureMessage += reviewMessage;
+        }
+        QMessageBox::information(this, u8"完成", u8"翻译完成！\n结果已保存到: " + outputFilePath + failureMessage);
     } catch (const std::exception &e) {
         addLogMessage(u8"保存文件失败: " + QString::fromStdString(e.what()));
         QMessageBox::warning(this, u8"错误", u8"保存文件失败: " + QString::fromStdString(e.what()));
     }
     
-    // 清理线程
-    if (m_translationThread) {
-        m_translationThread->quit();
-        m_translationThread->wait();
-        m_translationThread->deleteLater();
-        m_translationThread = nullptr;
-    }
-    
-    if (m_translationWorker) {
-        m_translationWorker->deleteLater();
-        m_translationWorker = nullptr;
+    // 清理工作线程
+    if (m_scheduler) {
+        m_scheduler->deleteLater();
+        m_scheduler = nullptr;
     }
 }
 
 void MainWindow::onTranslationError(const QString &error)
 {
     resetTranslationButtons();
+    if (m_journal) {
+        m_journal->sync();
+        addLogMessage(u8"已完成的翻译已记录到翻译日志，再次开始翻译时可以继续");
+    }
     addLogMessage(u8"翻译错误: " + error);
     QMessageBox::critical(this, u8"翻译错误", error);
 }
@@ -605,65 +802,78 @@ void MainWindow::onLogMessage(const QString &message)
 
 void MainWindow::updatePreviewTable()
 {
-    if (m_csvData.isEmpty()) {
-        ui->table_previewData->clear();
-        ui->table_previewData->setRowCount(0);
-        ui->table_previewData->setColumnCount(0);
-        return;
+    // 预览表格直接读取m_table，只需通知视图重新加载
+    m_previewModel->reload();
+    if (m_table.columnCount() > 0) {
+        resizePreviewColumns(0, m_table.columnCount() - 1);
     }
+}
+
+void MainWindow::openJournal(const QString &sourceColumn, QHash<QString, QBitArray> *resumedRows,
+                             QVector<TranslationReview> *resumedReviews)
+{
+    QString csvPath = m_table.filePath();
+    m_journal.reset(new TranslationJournal(TranslationJournal::pathFor(csvPath)));
     
-    // 设置表格行数和列数
-    ui->table_previewData->setRowCount(m_csvData.size());
-    ui->table_previewData->setColumnCount(m_csvHeaders.size());
+    QVector<TranslationResult> entries;
+    QVector<TranslationReview> reviews;
+    QString errorMessage;
+    if (!m_journal->open(TranslationJournal::fingerprint(csvPath, sourceColumn), &entries, &reviews, &errorMessage)) {
+        addLogMessage(u8"无法打开翻译日志，本次翻译中断后将无法继续: " + errorMessage);
+        m_journal.reset();
+        return;
+    }
+    if (entries.isEmpty()) {
+        return;
+    }
     
-    // 启用行间颜色交替
-    ui->table_previewData->setAlternatingRowColors(true);
+    QMessageBox::StandardButton answer = QMessageBox::question(this, u8"继续翻译",
+        QString(u8"发现上次未完成的翻译，已完成%1个单元格，是否继续？\n选择“否”将丢弃这些记录重新开始。").arg(entries.size()));
+    if (answer != QMessageBox::Yes) {
+        m_journal->reset();
+        addLogMessage(u8"已丢弃上次未完成的翻译记录");
+        return;
+    }
     
-    // 设置表头 - 将语言代码转换为中文显示
-    QStringList chineseHeaders;
-    for (const QString &header : m_csvHeaders) {
-        // 检查是否为支持的语言代码，如果是则显示中文名称
-        if (m_supportedLanguages.contains(header)) {
-            chineseHeaders.append(m_supportedLanguages[header]);
-        } else {
-            chineseHeaders.append(header);
+    applyTranslationResults(entries);
+    *resumedReviews = reviews;
+    for (const TranslationResult &result : entries) {
+        QBitArray &rows = (*resumedRows)[result.targetLang];
+        if (rows.isEmpty()) {
+            rows.resize(m_table.rowCount());
         }
-    }
-    ui->table_previewData->setHorizontalHeaderLabels(chineseHeaders);
-    
-    // 填充数据
-    for (int row = 0; row < m_csvData.size(); ++row) {
-        const QStringList &rowData = m_csvData[row];
-        for (int col = 0; col < m_csvHeaders.size(); ++col) {
-            QString cellText = (col < rowData.size()) ? rowData[col] : "";
-            QTableWidgetItem *item = new QTableWidgetItem(cellText);
-            
-            // 第一行（标题行）设置为只读并加粗
-            if (row == 0) {
-                QFont font = item->font();
-                font.setBold(true);
-                item->setFont(font);
-                item->setFlags(item->flags() & ~Qt::ItemIsEditable);
-                item->setBackground(QColor(240, 240, 240));
-            }
-            
-            ui->table_previewData->setItem(row, col, item);
+        if (result.row >= 0 && result.row < rows.size()) {
+            rows.setBit(result.row);
         }
     }
+    addLogMessage(QString(u8"已从翻译日志恢复%1个单元格").arg(entries.size()));
+}
+
+void MainWindow::resizePreviewColumns(int firstColumn, int lastColumn)
+{
+    // 只根据表头和抽样的部分行估算列宽，避免遍历整张表
+    const int sampleRows = 200;
+    const int maxColumnWidth = 300;
     
-    // 自动调整列宽
-    ui->table_previewData->resizeColumnsToContents();
+    QFontMetrics metrics(ui->table_previewData->font());
+    QFont boldFont = ui->table_previewData->font();
+    boldFont.setBold(true);
+    QFontMetrics boldMetrics(boldFont);
     
-    // 限制最大列宽，避免过宽
-    for (int col = 0; col < ui->table_previewData->columnCount(); ++col) {
-        if (ui->table_previewData->columnWidth(col) > 300) {
-            ui->table_previewData->setColumnWidth(col, 300);
+    int rows = m_table.rowCount();
+    int step = qMax(1, rows / sampleRows);
+    for (int col = firstColumn; col <= lastColumn; ++col) {
+        QString displayHeader = m_previewModel->headerData(col, Qt::Horizontal).toString();
+        int width = qMax(boldMetrics.horizontalAdvance(m_table.header(col)), metrics.horizontalAdvance(displayHeader));
+        for (int row = 0; row < rows; row += step) {
+            width = qMax(width, metrics.horizontalAdvance(m_table.cell(row, col).left(80)));
         }
+        
+        // 限制最大列宽，避免过宽
+        ui->table_previewData->setColumnWidth(col, qMin(width + 16, maxColumnWidth));
     }
 }
 
-
-
 void MainWindow::on_checkBox_idHide_stateChanged(int state)
 {
     ui->edit_id->setEchoMode(state == Qt::Checked ? QLineEdit::Password : QLineEdit::Normal);
@@ -678,7 +888,7 @@ void MainWindow::on_checkBox_keyHide_stateChanged(int state)
 
 void MainWindow::on_btn_saveCsv_clicked()
 {
-    if (m_csvData.isEmpty()) {
+    if (m_table.isEmpty()) {
         QMessageBox::warning(this, u8"警告", u8"没有可保存的CSV数据");
         return;
     }
@@ -697,7 +907,7 @@ void MainWindow::on_btn_saveCsv_clicked()
     }
 
     try {
-        saveCSV(saveFilePath, m_csvData);
+        saveCSV(saveFilePath);
         addLogMessage(u8"CSV数据已保存到: " + saveFilePath);
         QMessageBox::information(this, u8"保存成功", u8"CSV数据已成功保存！");
     } catch (const std::exception &e) {
@@ -706,36 +916,38 @@ void MainWindow::on_btn_saveCsv_clicked()
     }
 }
 
-void MainWindow::on_btn_setDelay_clicked()
+void MainWindow::on_comboBox_tier_currentIndexChanged(int index)
 {
-    QString delayText = ui->edit_delay->text().trimmed();
-    
-    // 检查输入是否为空
-    if (delayText.isEmpty()) {
-        QMessageBox::warning(this, u8"警告", u8"请输入延迟时间");
-        return;
-    }
-    
-    // 检查输入是否为正整数
-    bool ok;
-    int delayTime = delayText.toInt(&ok);
-    
-    if (!ok || delayTime <= 0) {
-        QMessageBox::warning(this, u8"警告", u8"延迟时间必须是正整数（毫秒）");
-        return;
+    QString tier = ui->comboBox_tier->itemData(index).toString();
+
+    // 非自定义类型使用百度开放平台对应版本的QPS上限
+    for (const AccountTier &preset : kAccountTiers) {
+        if (tier == preset.key) {
+            ui->spinBox_qps->setValue(preset.qps);
+            ui->spinBox_burst->setValue(preset.burst);
+            break;
+        }
     }
-    
+
+    bool custom = (tier == "custom");
+    ui->spinBox_qps->setEnabled(custom);
+    ui->spinBox_burst->setEnabled(custom);
+}
+
+void MainWindow::on_btn_setRate_clicked()
+{
     // 保存设置到配置文件
     saveSettings();
-    
+
     // 显示成功消息
-    QMessageBox::information(this, u8"成功", QString(u8"延迟时间已设置为 %1 毫秒").arg(delayTime));
-    addLogMessage(QString(u8"翻译延迟时间已设置为: %1 毫秒").arg(delayTime));
+    QString rateText = QString(u8"%1 次/秒，突发 %2 次").arg(ui->spinBox_qps->value()).arg(ui->spinBox_burst->value());
+    QMessageBox::information(this, u8"成功", u8"限速已设置为 " + rateText);
+    addLogMessage(u8"翻译限速已设置为: " + rateText);
 }
 
 void MainWindow::on_btn_previewWrite_clicked()
 {
-    if (ui->table_previewData->rowCount() == 0 || ui->table_previewData->columnCount() == 0) {
+    if (m_previewModel->rowCount() == 0 || m_previewModel->columnCount() == 0) {
         QMessageBox::warning(this, u8"警告", u8"预览表格为空，无法写入数据");
         return;
     }
@@ -768,39 +980,9 @@ void MainWindow::on_btn_previewWrite_clicked()
     }
     
     try {
-        // 构建要保存的CSV数据
-        QList<QStringList> saveData;
-        
-        // 使用原始的CSV表头（语言代码），而不是显示的中文名称
-        QStringList csvHeaders;
-        for (int col = 0; col < ui->table_previewData->columnCount(); ++col) {
-            if (col < m_csvHeaders.size()) {
-                csvHeaders.append(m_csvHeaders[col]);
-            } else {
-                csvHeaders.append(QString("Column_%1").arg(col + 1));
-            }
-        }
-        
-        // 添加表头作为第一行
-        saveData.append(csvHeaders);
-        
-        // 构建数据行（跳过第一行，因为第一行是表头数据）
-        for (int row = 1; row < ui->table_previewData->rowCount(); ++row) {
-            QStringList rowData;
-            for (int col = 0; col < ui->table_previewData->columnCount(); ++col) {
-                QTableWidgetItem *item = ui->table_previewData->item(row, col);
-                QString cellText = item ? item->text() : "";
-                rowData.append(cellText);
-            }
-            saveData.append(rowData);
-        }
-        
-        // 更新内部数据结构
-        m_csvData.clear();
-        m_csvData = saveData;
-        
-        // 保存到CSV文件
-        saveCSV(saveFilePath, saveData);
+        // 预览表格中的编辑已经通过模型直接写入内部数据，
+        // 表头保持原始的语言代码，而不是显示的中文名称
+        saveCSV(saveFilePath);
         
         // 更新源语言下拉框
         updateSourceLanguageCombo();
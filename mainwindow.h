@@ -14,7 +14,11 @@
 #include <QPushButton>
 #include <QTimer>
 #include <QThread>
-#include "translationworker.h"
+#include "translationscheduler.h"
+#include "translationjournal.h"
+#include "translationmanifest.h"
+#include "logmodel.h"
+#include "metricsmodel.h"
 #include <QStandardPaths>
 #include <QDir>
 #include <QDragEnterEvent>
@@ -29,7 +33,12 @@
 #include <QRegularExpression>
 #include <QTextStream>
 #include <QFile>
+#include <QHeaderView>
+#include <QScrollBar>
+#include <QFontMetrics>
+#include <QScopedPointer>
 #include "appobject.h"
+#include "csvtablemodel.h"
 
 namespace Ui {
 class MainWindow;
@@ -75,8 +84,9 @@ private slots:
     void on_btn_stop_clicked();
 
     // 翻译进度更新
-    void onTranslationProgress(int current, int total, const QString &currentText, const QString &translatedText, const QString &targetLang);
+    void onTranslationProgress(const TranslationProgress &progress);
     void onTranslationFinished();
+    void onTranslationStopped();
     void onTranslationError(const QString &error);
     void onLogMessage(const QString &message);
     void updatePreviewTable();
@@ -90,8 +100,11 @@ private slots:
     // 隐藏/显示API Key
     void on_checkBox_keyHide_stateChanged(int state);
 
-    // 设置翻译延迟时间
-    void on_btn_setDelay_clicked();
+    // 切换百度账号类型时更新限速参数
+    void on_comboBox_tier_currentIndexChanged(int index);
+
+    // 保存翻译限速设置
+    void on_btn_setRate_clicked();
     
     // 预览界面写入按钮
     void on_btn_previewWrite_clicked();
@@ -102,6 +115,9 @@ private:
     void loadSettings();
     void saveSettings();
     void setupLanguageCheckboxes();
+    void warmUpConnections();
+    void setupLogView();
+    void setupMetricsView();
     void loadCSVFile(const QString &filePath);
     void updateSourceLanguageCombo();
     void addLogMessage(const QString &message);
@@ -109,18 +125,32 @@ private:
     void resetTranslationButtons();
     QStringList getSelectedTargetLanguages();
     void selectAllLanguages(bool select);
+    void resizePreviewColumns(int firstColumn, int lastColumn);
+    void applyTranslationResults(const QVector<TranslationResult> &results);
+    void applyReviews(const QVector<TranslationReview> &reviews);
+    void openJournal(const QString &sourceColumn, QHash<QString, QBitArray> *resumedRows,
+                     QVector<TranslationReview> *resumedReviews);
     
     // CSV相关方法
-    QList<QStringList> parseCSV(const QString &filePath);
-    void saveCSV(const QString &filePath, const QList<QStringList> &data);
+    void saveCSV(const QString &filePath);
     
     Ui::MainWindow *ui;
     QSettings *m_settings;
-    QList<QStringList> m_csvData;
-    QStringList m_csvHeaders;
+    CsvTable m_table;
+    CsvTableModel *m_previewModel;
     QList<QCheckBox*> m_languageCheckboxes;
-    QThread *m_translationThread;
-    TranslationWorker *m_translationWorker;
+    TranslationScheduler *m_scheduler;
+    QSharedPointer<TranslationMemory> m_translationMemory;
+    QScopedPointer<TranslationJournal> m_journal;
+    TranslationManifest m_manifest;  // 译文对应的原文版本，随结果文件保存
+    int m_sourceColumnIndex = -1;    // 本次翻译的源语言列
+    QVector<TranslationFailure> m_failures; // 本次翻译中多次重试仍失败的单元格
+    QVector<TranslationReview> m_reviews;   // 本次翻译中使用相似原文译文的单元格
+    LogModel *m_logModel = nullptr;
+    LogFilterModel *m_logFilter = nullptr;
+    bool m_logFollowTail = true; // 视图停在底部时新日志插入后继续滚到底部
+    MetricsModel *m_metricsModel = nullptr;
+    QTimer *m_metricsTimer = nullptr;
     
     // 支持的28种语言
     QMap<QString, QString> m_supportedLanguages;
@@ -0,0 +1,96 @@
+﻿#include "metricsmodel.h"
+
+MetricsModel::MetricsModel(QObject *parent) : QAbstractTableModel(parent)
+{
+}
+
+void MetricsModel::refresh()
+{
+    QVector<MetricsRegistry::Sample> samples = MetricsRegistry::instance()->snapshot();
+    if (samples.size() != m_samples.size()) {
+        beginResetModel();
+        m_samples.swap(samples);
+        endResetModel();
+        return;
+    }
+
+    m_samples.swap(samples);
+    if (!m_samples.isEmpty()) {
+        emit dataChanged(index(0, 0), index(m_samples.size() - 1, ColumnCount - 1), { Qt::DisplayRole });
+    }
+}
+
+int MetricsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_samples.size();
+}
+
+int MetricsModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(ColumnCount);
+}
+
+QVariant MetricsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_samples.size()) {
+        return QVariant();
+    }
+
+    const MetricsRegistry::Sample &sample = m_samples[index.row()];
+    if (role == Qt::TextAlignmentRole && index.column() >= ValueColumn) {
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    // 直方图的数值列为样本数，其余列为毫秒
+    bool histogram = sample.type == MetricsRegistry::Histogram;
+    switch (index.column()) {
+    case NameColumn:
+        return sample.name;
+    case LabelColumn:
+        return sample.label;
+    case ValueColumn:
+        return sample.type == MetricsRegistry::Gauge ? QString::number(sample.value, 'f', 1)
+                                                     : QString::number(qint64(sample.value));
+    case AverageColumn:
+        return histogram ? QString::number(sample.average, 'f', 2) : QString();
+    case P50Column:
+        return histogram ? QString::number(sample.p50, 'f', 2) : QString();
+    case P90Column:
+        return histogram ? QString::number(sample.p90, 'f', 2) : QString();
+    case P99Column:
+        return histogram ? QString::number(sample.p99, 'f', 2) : QString();
+    default:
+        break;
+    }
+    return QVariant();
+}
+
+QVariant MetricsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section) {
+    case NameColumn:
+        return QString(u8"指标");
+    case LabelColumn:
+        return QString(u8"标签");
+    case ValueColumn:
+        return QString(u8"数值/样本数");
+    case AverageColumn:
+        return QString(u8"平均(毫秒)");
+    case P50Column:
+        return QString("p50");
+    case P90Column:
+        return QString("p90");
+    case P99Column:
+        return QString("p99");
+    default:
+        break;
+    }
+    return QVariant();
+}
@@ -0,0 +1,39 @@
+#ifndef METRICSMODEL_H
+#define METRICSMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include "metricsregistry.h"
+
+// 运行统计面板的表格模型，每次refresh()从MetricsRegistry取一份快照
+// 指标数量不变时只通知数值变化，视图的滚动位置和选择保持不动
+class MetricsModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        NameColumn = 0,
+        LabelColumn,
+        ValueColumn,
+        AverageColumn,
+        P50Column,
+        P90Column,
+        P99Column,
+        ColumnCount
+    };
+
+    explicit MetricsModel(QObject *parent = nullptr);
+
+    void refresh();
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    QVector<MetricsRegistry::Sample> m_samples;
+};
+
+#endif // METRICSMODEL_H
@@ -0,0 +1,353 @@
+﻿#include "metricsregistry.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTextStream>
+
+namespace {
+
+struct MetricHelp
+{
+    const char *name;
+    const char *help;
+};
+
+// Prometheus的HELP行
+const MetricHelp kMetricHelp[] = {
+    { kMetricRequests, "Translation requests sent, by backend" },
+    { kMetricRequestErrors, "Failed requests, by API error_code or network failure" },
+    { kMetricRetries, "Requests scheduled for retry after a failure" },
+    { kMetricCacheHits, "Unique texts answered without a request, by source" },
+    { kMetricCellsSkipped, "Cells completed without translation, by reason" },
+    { kMetricCellsDeduplicated, "Cells sharing a request with an identical text" },
+    { kMetricCellsCompleted, "Cells completed in the run" },
+    { kMetricRequestBytes, "Request body bytes sent" },
+    { kMetricResponseBytes, "Response body bytes received" },
+    { kMetricBilledCharacters, "Source characters in successful requests, by backend" },
+    { kMetricInFlight, "Requests currently in flight" },
+    { kMetricRunElapsed, "Wall time of the run in milliseconds" },
+    { kMetricCellsPerSecond, "Completed cells per second over the run" },
+    { kMetricRequestDuration, "Request duration from send to last byte in milliseconds" },
+    { kMetricRequestTtfb, "Request time to first byte in milliseconds" },
+    { kMetricParseDuration, "Time spent decoding a reply in milliseconds" },
+    { kMetricUiUpdateDuration, "Time spent applying one progress batch to the table in milliseconds" },
+};
+
+QString helpFor(const QString &name)
+{
+    for (const MetricHelp &help : kMetricHelp) {
+        if (name == QLatin1String(help.name)) {
+            return QString::fromLatin1(help.help);
+        }
+    }
+    return QString();
+}
+
+const char *typeName(MetricsRegistry::Type type)
+{
+    switch (type) {
+    case MetricsRegistry::Counter:
+        return "counter";
+    case MetricsRegistry::Gauge:
+        return "gauge";
+    case MetricsRegistry::Histogram:
+        return "histogram";
+    }
+    return "untyped";
+}
+
+QString escapeLabel(QString value)
+{
+    value.replace(QLatin1Char('\\'), QLatin1String("\\\\"));
+    value.replace(QLatin1Char('"'), QLatin1String("\\\""));
+    value.replace(QLatin1Char('\n'), QLatin1String("\\n"));
+    return value;
+}
+
+QString formatValue(double value)
+{
+    return QString::number(value, 'g', 15);
+}
+
+} // namespace
+
+const double MetricHistogram::kBucketBounds[MetricHistogram::kBucketCount] = {
+    0.1, 0.25, 0.5, 1, 2.5, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000
+};
+
+void MetricGauge::add(double value)
+{
+    double current = m_value.load(std::memory_order_relaxed);
+    while (!m_value.compare_exchange_weak(current, current + value, std::memory_order_relaxed)) {
+    }
+}
+
+MetricHistogram::MetricHistogram()
+{
+    reset();
+}
+
+void MetricHistogram::observe(double ms)
+{
+    int index = 0;
+    while (index < kBucketCount && ms > kBucketBounds[index]) {
+        ++index;
+    }
+    m_buckets[index].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumMicros.fetch_add(qint64(ms * 1000.0), std::memory_order_relaxed);
+}
+
+double MetricHistogram::quantile(double q) const
+{
+    const quint64 total = count();
+    if (total == 0) {
+        return 0.0;
+    }
+
+    const double rank = q * total;
+    quint64 cumulative = 0;
+    for (int i = 0; i <= kBucketCount; ++i) {
+        const quint64 inBucket = bucket(i);
+        if (inBucket > 0 && cumulative + inBucket >= rank) {
+            // 超过最大边界的样本无法插值，按最大边界计
+            if (i == kBucketCount) {
+                return kBucketBounds[kBucketCount - 1];
+            }
+            const double lower = i == 0 ? 0.0 : kBucketBounds[i - 1];
+            return lower + (kBucketBounds[i] - lower) * (rank - cumulative) / inBucket;
+        }
+        cumulative += inBucket;
+    }
+    return kBucketBounds[kBucketCount - 1];
+}
+
+void MetricHistogram::reset()
+{
+    for (std::atomic<quint64> &bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sumMicros.store(0, std::memory_order_relaxed);
+}
+
+MetricsRegistry *MetricsRegistry::instance()
+{
+    static MetricsRegistry registry;
+    return &registry;
+}
+
+MetricsRegistry::MetricsRegistry()
+{
+}
+
+MetricsRegistry::~MetricsRegistry()
+{
+    for (const Entry &entry : m_entries) {
+        delete entry.counter;
+        delete entry.gauge;
+        delete entry.histogram;
+    }
+}
+
+MetricCounter *MetricsRegistry::counter(const QString &name, const QString &labelName, const QString &labelValue)
+{
+    return entry(name, labelName, labelValue, Counter)->counter;
+}
+
+MetricGauge *MetricsRegistry::gauge(const QString &name, const QString &labelName, const QString &labelValue)
+{
+    return entry(name, labelName, labelValue, Gauge)->gauge;
+}
+
+MetricHistogram *MetricsRegistry::histogram(const QString &name, const QString &labelName, const QString &labelValue)
+{
+    return entry(name, labelName, labelValue, Histogram)->histogram;
+}
+
+MetricsRegistry::Entry *MetricsRegistry::entry(const QString &name, const QString &labelName, const QString &labelValue,
+                                               Type type)
+{
+    const QString key = name + QLatin1Char('\0') + labelName + QLatin1Char('\0') + labelValue;
+    QMutexLocker locker(&m_mutex);
+    QMap<QString, Entry>::iterator it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        Q_ASSERT(it->type == type);
+        return &it.value();
+    }
+
+    // QMap插入不会移动已有节点，返回的指针一直有效
+    Entry entry;
+    entry.name = name;
+    entry.labelName = labelName;
+    entry.labelValue = labelValue;
+    entry.type = type;
+    switch (type) {
+    case Counter:
+        entry.counter = new MetricCounter();
+        break;
+    case Gauge:
+        entry.gauge = new MetricGauge();
+        break;
+    case Histogram:
+        entry.histogram = new MetricHistogram();
+        break;
+    }
+    return &m_entries.insert(key, entry).value();
+}
+
+void MetricsRegistry::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    for (const Entry &entry : m_entries) {
+        if (entry.counter) {
+            entry.counter->reset();
+        }
+        if (entry.gauge) {
+            entry.gauge->reset();
+        }
+        if (entry.histogram) {
+            entry.histogram->reset();
+        }
+    }
+}
+
+QVector<MetricsRegistry::Sample> MetricsRegistry::snapshot() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVector<Sample> samples;
+    samples.reserve(m_entries.size());
+    for (const Entry &entry : m_entries) {
+        Sample sample;
+        sample.name = entry.name;
+        if (!entry.labelName.isEmpty()) {
+            sample.label = QString("%1=\"%2\"").arg(entry.labelName, entry.labelValue);
+        }
+        sample.type = entry.type;
+        if (entry.counter) {
+            sample.value = entry.counter->value();
+        } else if (entry.gauge) {
+            sample.value = entry.gauge->value();
+        } else if (entry.histogram) {
+            const quint64 count = entry.histogram->count();
+            sample.value = count;
+            sample.average = count > 0 ? entry.histogram->sum() / count : 0.0;
+            sample.p50 = entry.histogram->quantile(0.5);
+            sample.p90 = entry.histogram->quantile(0.9);
+            sample.p99 = entry.histogram->quantile(0.99);
+        }
+        samples.append(sample);
+    }
+    return samples;
+}
+
+QJsonObject MetricsRegistry::toJson() const
+{
+    QMutexLocker locker(&m_mutex);
+    QJsonArray metrics;
+    for (const Entry &entry : m_entries) {
+        QJsonObject metric;
+        metric["name"] = entry.name;
+        metric["type"] = QString::fromLatin1(typeName(entry.type));
+        if (!entry.labelName.isEmpty()) {
+            QJsonObject labels;
+            labels[entry.labelName] = entry.labelValue;
+            metric["labels"] = labels;
+        }
+        if (entry.counter) {
+            metric["value"] = double(entry.counter->value());
+        } else if (entry.gauge) {
+            metric["value"] = entry.gauge->value();
+        } else if (entry.histogram) {
+            const MetricHistogram *histogram = entry.histogram;
+            QJsonArray buckets;
+            quint64 cumulative = 0;
+            for (int i = 0; i < MetricHistogram::kBucketCount; ++i) {
+                cumulative += histogram->bucket(i);
+                QJsonObject bucket;
+                bucket["le"] = MetricHistogram::kBucketBounds[i];
+                bucket["count"] = double(cumulative);
+                buckets.append(bucket);
+            }
+            metric["count"] = double(histogram->count());
+            metric["sum"] = histogram->sum();
+            metric["p50"] = histogram->quantile(0.5);
+            metric["p90"] = histogram->quantile(0.9);
+            metric["p99"] = histogram->quantile(0.99);
+            metric["buckets"] = buckets;
+        }
+        metrics.append(metric);
+    }
+
+    QJsonObject root;
+    root["version"] = QCoreApplication::applicationVersion();
+    root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    root["metrics"] = metrics;
+    return root;
+}
+
+QString MetricsRegistry::toPrometheus() const
+{
+    QMutexLocker locker(&m_mutex);
+    QString text;
+    QTextStream out(&text);
+    QString lastName;
+    for (const Entry &entry : m_entries) {
+        // 同名不同标签的指标只写一次HELP和TYPE
+        if (entry.name != lastName) {
+            const QString help = helpFor(entry.name);
+            if (!help.isEmpty()) {
+                out << "# HELP " << entry.name << ' ' << help << '\n';
+            }
+            out << "# TYPE " << entry.name << ' ' << typeName(entry.type) << '\n';
+            lastName = entry.name;
+        }
+
+        const QString label = entry.labelName.isEmpty()
+                              ? QString()
+                              : QString("%1=\"%2\"").arg(entry.labelName, escapeLabel(entry.labelValue));
+        if (entry.histogram) {
+            const QString prefix = label.isEmpty() ? QString() : label + ',';
+            quint64 cumulative = 0;
+            for (int i = 0; i < MetricHistogram::kBucketCount; ++i) {
+                cumulative += entry.histogram->bucket(i);
+                out << entry.name << "_bucket{" << prefix << "le=\"" << formatValue(MetricHistogram::kBucketBounds[i])
+                    << "\"} " << cumulative << '\n';
+            }
+            out << entry.name << "_bucket{" << prefix << "le=\"+Inf\"} " << entry.histogram->count() << '\n';
+            const QString suffix = label.isEmpty() ? QString() : '{' + label + '}';
+            out << entry.name << "_sum" << suffix << ' ' << formatValue(entry.histogram->sum()) << '\n';
+            out << entry.name << "_count" << suffix << ' ' << entry.histogram->count() << '\n';
+            continue;
+        }
+
+        out << entry.name;
+        if (!label.isEmpty()) {
+            out << '{' << label << '}';
+        }
+        out << ' ' << formatValue(entry.counter ? double(entry.counter->value()) : entry.gauge->value()) << '\n';
+    }
+    out.flush();
+    return text;
+}
+
+bool MetricsRegistry::save(const QString &basePath, QString *errorMessage) const
+{
+    const QByteArray json = QJsonDocument(toJson()).toJson(QJsonDocument::Indented);
+    const QByteArray prometheus = toPrometheus().toUtf8();
+    const QString paths[2] = { basePath + ".json", basePath + ".prom" };
+    const QByteArray *contents[2] = { &json, &prometheus };
+    for (int i = 0; i < 2; ++i) {
+        QFile file(paths[i]);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(*contents[i]) != contents[i]->size()) {
+            if (errorMessage) {
+                *errorMessage = QString("%1: %2").arg(paths[i], file.errorString());
+            }
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,140 @@
+#ifndef METRICSREGISTRY_H
+#define METRICSREGISTRY_H
+
+#include <QJsonObject>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+// 指标名称，统一使用sgt_前缀，说明文字在metricsregistry.cpp中
+const char kMetricRequests[] = "sgt_requests_total";
+const char kMetricRequestErrors[] = "sgt_request_errors_total";
+const char kMetricRetries[] = "sgt_retries_total";
+const char kMetricCacheHits[] = "sgt_cache_hits_total";
+const char kMetricCellsSkipped[] = "sgt_cells_skipped_total";
+const char kMetricCellsDeduplicated[] = "sgt_cells_deduplicated_total";
+const char kMetricCellsCompleted[] = "sgt_cells_completed_total";
+const char kMetricRequestBytes[] = "sgt_request_bytes_total";
+const char kMetricResponseBytes[] = "sgt_response_bytes_total";
+const char kMetricBilledCharacters[] = "sgt_billed_characters_total";
+const char kMetricInFlight[] = "sgt_requests_in_flight";
+const char kMetricRunElapsed[] = "sgt_run_elapsed_ms";
+const char kMetricCellsPerSecond[] = "sgt_cells_per_second";
+const char kMetricRequestDuration[] = "sgt_request_duration_ms";
+const char kMetricRequestTtfb[] = "sgt_request_ttfb_ms";
+const char kMetricParseDuration[] = "sgt_parse_duration_ms";
+const char kMetricUiUpdateDuration[] = "sgt_ui_update_duration_ms";
+
+// 只增不减的计数
+class MetricCounter
+{
+public:
+    void add(qint64 value = 1) { m_value.fetch_add(value, std::memory_order_relaxed); }
+    qint64 value() const { return m_value.load(std::memory_order_relaxed); }
+    void reset() { m_value.store(0, std::memory_order_relaxed); }
+
+private:
+    std::atomic<qint64> m_value{0};
+};
+
+// 可增可减的当前值
+class MetricGauge
+{
+public:
+    void set(double value) { m_value.store(value, std::memory_order_relaxed); }
+    void add(double value);
+    double value() const { return m_value.load(std::memory_order_relaxed); }
+    void reset() { set(0.0); }
+
+private:
+    std::atomic<double> m_value{0.0};
+};
+
+// 毫秒耗时的直方图，所有直方图使用同一组桶边界
+class MetricHistogram
+{
+public:
+    static const int kBucketCount = 17;
+    static const double kBucketBounds[kBucketCount];
+
+    MetricHistogram();
+    void observe(double ms);
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    double sum() const { return m_sumMicros.load(std::memory_order_relaxed) / 1000.0; }
+    // 第index个桶(不累计)的样本数，index为kBucketCount时是超过最大边界的样本
+    quint64 bucket(int index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+    // 按桶内线性插值估计分位数，没有样本时返回0
+    double quantile(double q) const;
+    void reset();
+
+private:
+    std::atomic<quint64> m_buckets[kBucketCount + 1];
+    std::atomic<quint64> m_count{0};
+    std::atomic<qint64> m_sumMicros{0};
+};
+
+// 进程内的指标注册表：counter()/gauge()/histogram()按名称加锁查找，取得的指针在进程结束前一直有效，
+// 频繁更新的地方应在初始化时取一次指针保存下来，之后的更新只是原子操作，可在任意线程进行
+// 每个指标最多带一个标签，如sgt_request_errors_total{code="54003"}
+// 翻译开始时清零，结束时导出为JSON和Prometheus文本格式，供比较不同版本的吞吐量
+class MetricsRegistry
+{
+public:
+    enum Type {
+        Counter,
+        Gauge,
+        Histogram
+    };
+
+    // 界面显示用的一行数据
+    struct Sample
+    {
+        QString name;
+        QString label;  // 形如code="54003"，没有标签时为空
+        Type type = Counter;
+        double value = 0.0;   // 计数和当前值；直方图为样本数
+        double average = 0.0; // 以下只用于直方图
+        double p50 = 0.0;
+        double p90 = 0.0;
+        double p99 = 0.0;
+    };
+
+    static MetricsRegistry *instance();
+    ~MetricsRegistry();
+
+    MetricCounter *counter(const QString &name, const QString &labelName = QString(), const QString &labelValue = QString());
+    MetricGauge *gauge(const QString &name, const QString &labelName = QString(), const QString &labelValue = QString());
+    MetricHistogram *histogram(const QString &name, const QString &labelName = QString(), const QString &labelValue = QString());
+
+    // 所有指标清零，已取得的指针仍然有效
+    void reset();
+
+    QVector<Sample> snapshot() const;
+    QJsonObject toJson() const;
+    QString toPrometheus() const;
+
+    // 写入basePath.json和basePath.prom
+    bool save(const QString &basePath, QString *errorMessage = nullptr) const;
+
+private:
+    struct Entry
+    {
+        QString name;
+        QString labelName;
+        QString labelValue;
+        Type type = Counter;
+        MetricCounter *counter = nullptr;
+        MetricGauge *gauge = nullptr;
+        MetricHistogram *histogram = nullptr;
+    };
+
+    MetricsRegistry();
+    Entry *entry(const QString &name, const QString &labelName, const QString &labelValue, Type type);
+
+    mutable QMutex m_mutex;
+    QMap<QString, Entry> m_entries; // 按名称和标签排序，导出时顺序固定
+};
+
+#endif // METRICSREGISTRY_H
@@ -0,0 +1,168 @@
+﻿#include "mockbaiduserver.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <QUrlQuery>
+
+MockBaiduServer::MockBaiduServer(QObject *parent) : QTcpServer(parent)
+{
+    m_clock.start();
+}
+
+void MockBaiduServer::setLatency(int latencyMs, int jitterMs)
+{
+    m_latencyMs = qMax(0, latencyMs);
+    m_jitterMs = qMax(0, jitterMs);
+}
+
+void MockBaiduServer::setErrorRate(double errorRate)
+{
+    m_errorRate = qBound(0.0, errorRate, 1.0);
+}
+
+void MockBaiduServer::setQpsLimit(int qpsLimit)
+{
+    m_qpsLimit = qMax(0, qpsLimit);
+}
+
+bool MockBaiduServer::start()
+{
+    return listen(QHostAddress::LocalHost, 0);
+}
+
+QUrl MockBaiduServer::endpoint() const
+{
+    return QUrl(QString("http://127.0.0.1:%1/api/trans/vip/translate").arg(serverPort()));
+}
+
+int MockBaiduServer::requestCount() const
+{
+    return m_requestCount;
+}
+
+int MockBaiduServer::rejectedCount() const
+{
+    return m_rejectedCount;
+}
+
+void MockBaiduServer::incomingConnection(qintptr socketDescriptor)
+{
+    QTcpSocket *socket = new QTcpSocket(this);
+    if (!socket->setSocketDescriptor(socketDescriptor)) {
+        delete socket;
+        return;
+    }
+
+    m_buffers.insert(socket, QByteArray());
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+        onReadyRead(socket);
+    });
+    connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+        m_buffers.remove(socket);
+        socket->deleteLater();
+    });
+}
+
+void MockBaiduServer::onReadyRead(QTcpSocket *socket)
+{
+    QByteArray &buffer = m_buffers[socket];
+    buffer.append(socket->readAll());
+
+    // 同一连接上可能先后收到多个请求（keep-alive）
+    for (;;) {
+        int headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+
+        int contentLength = 0;
+        const QList<QByteArray> headerLines = buffer.left(headerEnd).split('\n');
+        for (const QByteArray &line : headerLines) {
+            int colon = line.indexOf(':');
+            if (colon > 0 && line.left(colon).trimmed().toLower() == "content-length") {
+                contentLength = line.mid(colon + 1).trimmed().toInt();
+            }
+        }
+
+        int requestSize = headerEnd + 4 + contentLength;
+        if (buffer.size() < requestSize) {
+            return;
+        }
+
+        QByteArray json = handleRequest(buffer.mid(headerEnd + 4, contentLength));
+        buffer.remove(0, requestSize);
+
+        // 延迟到期前连接已关闭时定时器随socket一起销毁
+        int delay = m_latencyMs + (m_jitterMs > 0 ? QRandomGenerator::global()->bounded(m_jitterMs + 1) : 0);
+        QTimer::singleShot(delay, socket, [this, socket, json]() {
+            writeResponse(socket, json);
+        });
+    }
+}
+
+QByteArray MockBaiduServer::handleRequest(const QByteArray &body)
+{
+    m_requestCount++;
+
+    // 滑动窗口统计最近一秒的请求数
+    qint64 now = m_clock.elapsed();
+    while (!m_recentRequests.isEmpty() && now - m_recentRequests.head() >= 1000) {
+        m_recentRequests.dequeue();
+    }
+    if (m_qpsLimit > 0 && m_recentRequests.size() >= m_qpsLimit) {
+        m_rejectedCount++;
+        return errorResponse("54003", "Invalid Access Limit");
+    }
+    m_recentRequests.enqueue(now);
+
+    if (m_errorRate > 0 && QRandomGenerator::global()->generateDouble() < m_errorRate) {
+        m_rejectedCount++;
+        return errorResponse("52001", "TIMEOUT");
+    }
+
+    QUrlQuery query(QString::fromUtf8(body));
+    QString text = query.queryItemValue("q", QUrl::FullyDecoded);
+    QString from = query.queryItemValue("from", QUrl::FullyDecoded);
+    QString to = query.queryItemValue("to", QUrl::FullyDecoded);
+    if (text.isEmpty() || to.isEmpty()) {
+        return errorResponse("54000", "PARAM_FROM_TO_OR_Q_EMPTY");
+    }
+
+    // 与百度接口一样按换行拆成多段，每段返回一条结果
+    QJsonArray transResult;
+    const QStringList segments = text.split('\n');
+    for (const QString &segment : segments) {
+        QJsonObject item;
+        item["src"] = segment;
+        item["dst"] = QString("[%1] %2").arg(to, segment);
+        transResult.append(item);
+    }
+
+    QJsonObject obj;
+    obj["from"] = from == "auto" ? QString("zh") : from;
+    obj["to"] = to;
+    obj["trans_result"] = transResult;
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+
+QByteArray MockBaiduServer::errorResponse(const QString &errorCode, const QString &errorMessage)
+{
+    QJsonObject obj;
+    obj["error_code"] = errorCode;
+    obj["error_msg"] = errorMessage;
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
+
+void MockBaiduServer::writeResponse(QTcpSocket *socket, const QByteArray &json)
+{
+    QByteArray response = "HTTP/1.1 200 OK\r\n"
+                          "Content-Type: application/json; charset=utf-8\r\n"
+                          "Connection: keep-alive\r\n"
+                          "Content-Length: " + QByteArray::number(json.size()) + "\r\n\r\n";
+    response.append(json);
+    socket->write(response);
+}
@@ -0,0 +1,54 @@
+#ifndef MOCKBAIDUSERVER_H
+#define MOCKBAIDUSERVER_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QQueue>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUrl>
+
+// 本地模拟的百度通用翻译接口，用于在没有百度账号的情况下测量和回归翻译速度
+// 支持以换行分隔的多段文本，可模拟响应延迟、随机错误和QPS限制
+class MockBaiduServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    explicit MockBaiduServer(QObject *parent = nullptr);
+
+    // 每个请求的响应延迟为latencyMs加上[0, jitterMs]内的随机值
+    void setLatency(int latencyMs, int jitterMs = 0);
+    // 按此概率返回52001(请求超时)错误
+    void setErrorRate(double errorRate);
+    // 最近一秒内收到的请求超过此数时返回54003(访问频率受限)，0表示不限制
+    void setQpsLimit(int qpsLimit);
+
+    // 监听本机的随机端口
+    bool start();
+    QUrl endpoint() const;
+
+    int requestCount() const;
+    int rejectedCount() const;
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+
+private:
+    void onReadyRead(QTcpSocket *socket);
+    QByteArray handleRequest(const QByteArray &body);
+    QByteArray errorResponse(const QString &errorCode, const QString &errorMessage);
+    void writeResponse(QTcpSocket *socket, const QByteArray &json);
+
+    int m_latencyMs = 0;
+    int m_jitterMs = 0;
+    double m_errorRate = 0.0;
+    int m_qpsLimit = 0;
+    int m_requestCount = 0;
+    int m_rejectedCount = 0;
+    QElapsedTimer m_clock;
+    QQueue<qint64> m_recentRequests;
+    QHash<QTcpSocket *, QByteArray> m_buffers;
+};
+
+#endif // MOCKBAIDUSERVER_H
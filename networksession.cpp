@@ -0,0 +1,141 @@
+﻿#include "networksession.h"
+
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QSslSocket>
+
+NetworkSession::NetworkSession(QObject *parent) : QObject(parent),
+    m_networkManager(new QNetworkAccessManager(this))
+{
+    // 所有请求共用一份SSL配置，配置相同的请求才能复用同一个连接
+    m_sslConfig = QSslConfiguration::defaultConfiguration();
+    m_sslConfig.setProtocol(QSsl::TlsV1_2OrLater);
+    m_sslConfig.setPeerVerifyMode(QSslSocket::VerifyNone);
+    m_sslConfig.setAllowedNextProtocols(QList<QByteArray>() << QSslConfiguration::ALPNProtocolHTTP2
+                                                            << QSslConfiguration::NextProtocolHttp1_1);
+    m_clock.start();
+}
+
+QNetworkReply *NetworkSession::post(QNetworkRequest request, const QByteArray &body)
+{
+    if (request.url().scheme() == "https") {
+        request.setSslConfiguration(m_sslConfig);
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+    // 服务器通过ALPN协商支持HTTP/2时，同一连接上多路复用所有请求，否则退回HTTP/1.1长连接
+    request.setAttribute(QNetworkRequest::HTTP2AllowedAttribute, true);
+#endif
+
+    QNetworkReply *reply = m_networkManager->post(request, body);
+    reply->setProperty("sessionSentAt", m_clock.elapsed());
+
+    // 以下连接先于调用者的连接建立，finished时耗时已经记录好
+    connect(reply, &QNetworkReply::encrypted, this, [this, reply]() {
+        reply->setProperty("sessionTlsAt", m_clock.elapsed());
+    });
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, reply]() {
+        if (!reply->property("sessionFirstByteAt").isValid()) {
+            reply->setProperty("sessionFirstByteAt", m_clock.elapsed());
+        }
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        reply->setProperty("sessionFinishedAt", m_clock.elapsed());
+    });
+    return reply;
+}
+
+void NetworkSession::warmUp(const QList<QUrl> &urls)
+{
+    for (const QUrl &url : urls) {
+        if (!url.isValid() || url.host().isEmpty()) {
+            continue;
+        }
+
+        bool encrypted = url.scheme() == "https";
+        int port = url.port(encrypted ? 443 : 80);
+        QString key = QString("%1://%2:%3").arg(url.scheme(), url.host()).arg(port);
+        if (m_warmedHosts.contains(key)) {
+            continue;
+        }
+        m_warmedHosts.insert(key);
+
+        if (encrypted) {
+            if (QSslSocket::supportsSsl()) {
+                m_networkManager->connectToHostEncrypted(url.host(), quint16(port), m_sslConfig);
+            }
+        } else {
+            m_networkManager->connectToHost(url.host(), quint16(port));
+        }
+    }
+}
+
+RequestTiming NetworkSession::timing(QNetworkReply *reply) const
+{
+    RequestTiming timing;
+    qint64 sentAt = reply->property("sessionSentAt").toLongLong();
+    QVariant tlsAt = reply->property("sessionTlsAt");
+    if (tlsAt.isValid()) {
+        timing.tlsMs = tlsAt.toLongLong() - sentAt;
+    }
+    QVariant firstByteAt = reply->property("sessionFirstByteAt");
+    if (firstByteAt.isValid()) {
+        timing.ttfbMs = firstByteAt.toLongLong() - sentAt;
+    }
+    QVariant finishedAt = reply->property("sessionFinishedAt");
+    timing.totalMs = (finishedAt.isValid() ? finishedAt.toLongLong() : m_clock.elapsed()) - sentAt;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 9, 0)
+    timing.http2 = reply->attribute(QNetworkRequest::HTTP2WasUsedAttribute).toBool();
+#endif
+    return timing;
+}
+
+NetworkSessionPool *NetworkSessionPool::instance()
+{
+    static NetworkSessionPool *pool = nullptr;
+    if (!pool) {
+        pool = new NetworkSessionPool(QCoreApplication::instance());
+    }
+    return pool;
+}
+
+NetworkSessionPool::NetworkSessionPool(QObject *parent) : QObject(parent)
+{
+}
+
+NetworkSessionPool::~NetworkSessionPool()
+{
+    // 会话在各自线程结束时删除
+    for (QThread *thread : m_threads) {
+        thread->quit();
+    }
+    for (QThread *thread : m_threads) {
+        thread->wait();
+    }
+}
+
+NetworkSession *NetworkSessionPool::session(int index)
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_sessions.size() <= index) {
+        QThread *thread = new QThread(this);
+        NetworkSession *session = new NetworkSession();
+        session->moveToThread(thread);
+        connect(thread, &QThread::finished, session, &QObject::deleteLater);
+        thread->start();
+        m_threads.append(thread);
+        m_sessions.append(session);
+    }
+    return m_sessions[index];
+}
+
+void NetworkSessionPool::warmUp(const QList<QUrl> &urls)
+{
+    session(0);
+
+    QMutexLocker locker(&m_mutex);
+    for (NetworkSession *session : m_sessions) {
+        QMetaObject::invokeMethod(session, [session, urls]() {
+            session->warmUp(urls);
+        }, Qt::QueuedConnection);
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef NETWORKSESSION_H
+#define NETWORKSESSION_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QObject>
+#include <QSet>
+#include <QSslConfiguration>
+#include <QThread>
+#include <QUrl>
+#include <QVector>
+
+// 一次请求各阶段的耗时(毫秒)，-1表示该阶段没有发生
+struct RequestTiming
+{
+    qint64 tlsMs = -1;   // 从发出到TLS握手完成，复用已有连接时没有握手
+    qint64 ttfbMs = -1;  // 从发出到收到响应头，包含建立连接和服务器处理时间
+    qint64 totalMs = 0;  // 从发出到响应结束
+    bool http2 = false;
+};
+
+// 一个线程中长期存在的网络会话：所有请求共用同一个QNetworkAccessManager和SSL配置，
+// 连接在工作单元之间和多次翻译之间保持复用，服务器支持时通过HTTP/2多路复用
+// 会话只能在它所在的线程中使用
+class NetworkSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit NetworkSession(QObject *parent = nullptr);
+
+    // 发送POST请求并开始记录各阶段耗时
+    QNetworkReply *post(QNetworkRequest request, const QByteArray &body);
+
+    // 提前建立到这些地址的连接，第一个请求不必等待TCP和TLS握手，每个主机只预热一次
+    void warmUp(const QList<QUrl> &urls);
+
+    // 请求结束后读取耗时，只对本会话发出的请求有效
+    RequestTiming timing(QNetworkReply *reply) const;
+
+private:
+    QNetworkAccessManager *m_networkManager;
+    QSslConfiguration m_sslConfig;
+    QElapsedTimer m_clock;
+    QSet<QString> m_warmedHosts;
+};
+
+// 网络会话线程池：每个线程一个NetworkSession，在程序运行期间一直存在，
+// 翻译调度器按需借用，翻译结束后线程和连接保留给下一次翻译
+class NetworkSessionPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 池由QCoreApplication持有，程序退出时停止所有线程
+    static NetworkSessionPool *instance();
+    ~NetworkSessionPool();
+
+    // 第index个会话，不存在时创建线程；返回的会话位于自己的线程中
+    NetworkSession *session(int index);
+
+    // 在所有已创建的会话中预热连接，至少创建一个会话
+    void warmUp(const QList<QUrl> &urls);
+
+private:
+    explicit NetworkSessionPool(QObject *parent = nullptr);
+
+    QMutex m_mutex;
+    QVector<QThread *> m_threads;
+    QVector<NetworkSession *> m_sessions;
+};
+
+#endif // NETWORKSESSION_H
@@ -0,0 +1,61 @@
+#include "ratelimiter.h"
+
+#include <QtMath>
+
+RateLimiter::RateLimiter(double tokensPerSecond, int burst)
+    : m_tokensPerSecond(qMax(0.01, tokensPerSecond)),
+      m_burst(qMax(1, burst)),
+      m_tokens(m_burst)
+{
+    m_clock.start();
+}
+
+void RateLimiter::configure(double tokensPerSecond, int burst)
+{
+    QMutexLocker locker(&m_mutex);
+    refill();
+    m_tokensPerSecond = qMax(0.01, tokensPerSecond);
+    m_burst = qMax(1, burst);
+    m_tokens = qMin(m_tokens, double(m_burst));
+}
+
+double RateLimiter::tokensPerSecond() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_tokensPerSecond;
+}
+
+int RateLimiter::burst() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_burst;
+}
+
+int RateLimiter::tryAcquire()
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 now = m_clock.nsecsElapsed();
+    if (m_pausedUntilNs > now) {
+        return qMax(1, qCeil((m_pausedUntilNs - now) / 1e6));
+    }
+    refill();
+    if (m_tokens >= 1.0) {
+        m_tokens -= 1.0;
+        return 0;
+    }
+    return qMax(1, qCeil((1.0 - m_tokens) * 1000.0 / m_tokensPerSecond));
+}
+
+void RateLimiter::pauseFor(int ms)
+{
+    QMutexLocker locker(&m_mutex);
+    m_pausedUntilNs = qMax(m_pausedUntilNs, m_clock.nsecsElapsed() + qint64(ms) * 1000000);
+}
+
+void RateLimiter::refill()
+{
+    qint64 now = m_clock.nsecsElapsed();
+    double elapsedSeconds = (now - m_lastRefillNs) / 1e9;
+    m_lastRefillNs = now;
+    m_tokens = qMin(double(m_burst), m_tokens + elapsedSeconds * m_tokensPerSecond);
+}
@@ -0,0 +1,38 @@
+#ifndef RATELIMITER_H
+#define RATELIMITER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+
+// 令牌桶限流器：按tokensPerSecond匀速补充令牌，最多积攒burst个
+// 可被多个线程中的请求共享
+class RateLimiter
+{
+public:
+    explicit RateLimiter(double tokensPerSecond = 1.0, int burst = 1);
+
+    void configure(double tokensPerSecond, int burst);
+    double tokensPerSecond() const;
+    int burst() const;
+
+    // 取得一个令牌返回0，否则返回距离下一个令牌还需等待的毫秒数（不消耗令牌）
+    // 暂停期间返回暂停剩余的毫秒数
+    int tryAcquire();
+
+    // 服务器要求降速时暂停发放令牌，所有共享该限流器的线程都会等待，多次暂停取最晚的结束时间
+    void pauseFor(int ms);
+
+private:
+    void refill();
+
+    mutable QMutex m_mutex;
+    double m_tokensPerSecond;
+    int m_burst;
+    double m_tokens;
+    QElapsedTimer m_clock;
+    qint64 m_lastRefillNs = 0;
+    qint64 m_pausedUntilNs = 0;
+};
+
+#endif // RATELIMITER_H
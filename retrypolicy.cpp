@@ -0,0 +1,75 @@
+﻿#include "retrypolicy.h"
+
+#include <QRandomGenerator>
+
+namespace {
+
+// 频率受限不是请求本身的问题，允许多等几轮
+const int kSlowDownAttemptFactor = 4;
+
+} // namespace
+
+RetryPolicy::RetryPolicy(int maxAttempts, int baseDelayMs, int maxDelayMs)
+    : m_maxAttempts(qMax(1, maxAttempts)),
+      m_baseDelayMs(qMax(1, baseDelayMs)),
+      m_maxDelayMs(qMax(m_baseDelayMs, maxDelayMs))
+{
+}
+
+int RetryPolicy::maxAttempts(RetryAction action) const
+{
+    switch (action) {
+    case RetryAction::Retry:
+        return m_maxAttempts;
+    case RetryAction::SlowDown:
+        return m_maxAttempts * kSlowDownAttemptFactor;
+    default:
+        return 1;
+    }
+}
+
+int RetryPolicy::backoffMs(int attempt) const
+{
+    qint64 ceiling = m_baseDelayMs;
+    for (int i = 0; i < attempt && ceiling < m_maxDelayMs; ++i) {
+        ceiling *= 2;
+    }
+    ceiling = qMin<qint64>(ceiling, m_maxDelayMs);
+    return QRandomGenerator::global()->bounded(int(ceiling) + 1);
+}
+
+RetryAction RetryPolicy::classifyNetworkError(QNetworkReply::NetworkError error)
+{
+    switch (error) {
+    // 地址、认证或请求本身有误，重试没有意义
+    case QNetworkReply::ProtocolUnknownError:
+    case QNetworkReply::ProtocolInvalidOperationError:
+    case QNetworkReply::AuthenticationRequiredError:
+    case QNetworkReply::ContentAccessDenied:
+    case QNetworkReply::ContentNotFoundError:
+    case QNetworkReply::ContentOperationNotPermittedError:
+    case QNetworkReply::ProxyAuthenticationRequiredError:
+        return RetryAction::FailJob;
+    // 服务器繁忙
+    case QNetworkReply::ServiceUnavailableError:
+        return RetryAction::SlowDown;
+    // 超时、断线、DNS和SSL握手失败等通常是临时的
+    default:
+        return RetryAction::Retry;
+    }
+}
+
+QString RetryPolicy::actionName(RetryAction action)
+{
+    switch (action) {
+    case RetryAction::Retry:
+        return u8"重试";
+    case RetryAction::SlowDown:
+        return u8"降速重试";
+    case RetryAction::FailCell:
+        return u8"跳过该条";
+    case RetryAction::FailJob:
+        return u8"停止任务";
+    }
+    return QString();
+}
@@ -0,0 +1,38 @@
+#ifndef RETRYPOLICY_H
+#define RETRYPOLICY_H
+
+#include <QNetworkReply>
+
+// 请求失败后的处理方式
+enum class RetryAction
+{
+    Retry,      // 临时错误，退避后重试
+    SlowDown,   // 访问频率受限，暂停该账号后重试
+    FailCell,   // 只有这条文本无法翻译，记入失败列表
+    FailJob     // 账号或配置错误，重试也不会成功，停止整个任务
+};
+
+// 重试策略：指数退避加完全随机抖动，避免多个线程同时重试
+class RetryPolicy
+{
+public:
+    explicit RetryPolicy(int maxAttempts = 5, int baseDelayMs = 500, int maxDelayMs = 30000);
+
+    // 单条文本最多尝试的次数，频率受限的重试次数上限更高
+    int maxAttempts(RetryAction action) const;
+
+    // 第attempt次失败后的等待时间，在[0, min(maxDelay, baseDelay*2^attempt)]内随机
+    int backoffMs(int attempt) const;
+
+    // 网络层错误的分类，接口返回的错误码由各翻译接口自己分类
+    static RetryAction classifyNetworkError(QNetworkReply::NetworkError error);
+
+    static QString actionName(RetryAction action);
+
+private:
+    int m_maxAttempts;
+    int m_baseDelayMs;
+    int m_maxDelayMs;
+};
+
+#endif // RETRYPOLICY_H
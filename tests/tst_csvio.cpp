@@ -0,0 +1,75 @@
+﻿#include <QBuffer>
+#include <QtTest>
+
+#include "csvio.h"
+
+// CSV分块解析：记录跨越缓冲区和分块边界时的处理
+class TestCsvIo : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parseRecordNeedsMoreData();
+    void readerQuotedFieldAcrossChunks();
+};
+
+void TestCsvIo::parseRecordNeedsMoreData()
+{
+    QVector<CsvFieldSpan> fields;
+
+    // 引号内的换行不结束记录
+    const QByteArray open("a,\"line one\nline two");
+    QCOMPARE(Csv::parseRecord(open.constData(), open.size(), false, &fields), qint64(0));
+
+    // 缓冲区末尾的引号可能是转义引号的前一半
+    const QByteArray quote("a,\"say \"");
+    QCOMPARE(Csv::parseRecord(quote.constData(), quote.size(), false, &fields), qint64(0));
+
+    // \r后面可能还有\n
+    const QByteArray cr("a,b\r");
+    QCOMPARE(Csv::parseRecord(cr.constData(), cr.size(), false, &fields), qint64(0));
+    QCOMPARE(Csv::parseRecord(cr.constData(), cr.size(), true, &fields), qint64(cr.size()));
+    QCOMPARE(fields.size(), 2);
+
+    const QByteArray complete("a,\"x\"\"y\nz\"\r\nnext");
+    QCOMPARE(Csv::parseRecord(complete.constData(), complete.size(), false, &fields), qint64(12));
+    QCOMPARE(fields.size(), 2);
+    QCOMPARE(Csv::decodeField(complete.constData(), fields[1]), QString("x\"y\nz"));
+}
+
+void TestCsvIo::readerQuotedFieldAcrossChunks()
+{
+    const int chunkSize = 64 * 1024;
+    const QByteArray header("key,text\r\n");
+    const QByteArray quoted = QByteArray("k2,\"line one\r\nhe said \"\"hi\"\"\r\n") + QByteArray(u8"中文") + "\"\r\n";
+    const QString quotedText = QString::fromUtf8(u8"line one\r\nhe said \"hi\"\r\n中文");
+
+    const QByteArray prefix = QByteArray("\xEF\xBB\xBF") + header + "pad,";
+
+    // 让第一个分块的边界依次落在多行引号记录的每个字节上，包括转义引号、\r\n和多字节字符的中间
+    for (int shift = 0; shift <= quoted.size(); ++shift) {
+        const int padding = chunkSize - prefix.size() - 2 - shift;
+        QByteArray data = prefix + QByteArray(padding, 'x') + "\r\n";
+        data += quoted;
+        data += "k3,tail";
+
+        QBuffer buffer(&data);
+        QVERIFY(buffer.open(QIODevice::ReadOnly));
+        CsvReader reader(&buffer, chunkSize);
+        QStringList row;
+
+        QVERIFY(reader.readRow(&row));
+        QCOMPARE(row, QStringList() << "key" << "text");
+        QVERIFY(reader.readRow(&row));
+        QCOMPARE(row, QStringList() << "pad" << QString(padding, QLatin1Char('x')));
+        QVERIFY2(reader.readRow(&row), qPrintable(QString("shift %1").arg(shift)));
+        QCOMPARE(row, QStringList() << "k2" << quotedText);
+        QVERIFY(reader.readRow(&row));
+        QCOMPARE(row, QStringList() << "k3" << "tail");
+        QVERIFY(!reader.readRow(&row));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestCsvIo)
+
+#include "tst_csvio.moc"
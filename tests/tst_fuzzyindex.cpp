@@ -0,0 +1,111 @@
+﻿#include <QSet>
+#include <QtTest>
+
+#include "fuzzyindex.h"
+
+// 相似原文索引：前缀过滤后的结果必须与暴力计算一致
+class TestFuzzyIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void findMatchesBruteForce();
+    void findAtThreshold();
+
+private:
+    static QSet<quint64> grams(const QString &text);
+    static double jaccard(const QString &a, const QString &b);
+    static QStringList sampleCorpus();
+};
+
+QSet<quint64> TestFuzzyIndex::grams(const QString &text)
+{
+    // 与FuzzyIndex相同的三元组定义，用于暴力计算相似度
+    const QString padded = QLatin1Char(' ') + FuzzyIndex::canonicalText(text) + QLatin1Char(' ');
+    QSet<quint64> result;
+    for (int i = 0; i + 2 < padded.size(); ++i) {
+        result.insert((quint64(padded[i].unicode()) << 32) | (quint64(padded[i + 1].unicode()) << 16)
+                      | quint64(padded[i + 2].unicode()));
+    }
+    return result;
+}
+
+double TestFuzzyIndex::jaccard(const QString &a, const QString &b)
+{
+    const QSet<quint64> gramsA = grams(a);
+    const QSet<quint64> gramsB = grams(b);
+    const int overlap = QSet<quint64>(gramsA).intersect(gramsB).size();
+    return double(overlap) / double(gramsA.size() + gramsB.size() - overlap);
+}
+
+QStringList TestFuzzyIndex::sampleCorpus()
+{
+    const QStringList subjects = QStringList() << "The knight" << "A merchant" << "Your companion" << "The old wizard";
+    const QStringList verbs = QStringList() << "found" << "lost" << "sold" << "is looking for";
+    const QStringList objects = QStringList() << "a rusty sword" << "the golden key" << "three healing potions"
+                                              << "a map of the northern caves";
+    QStringList corpus;
+    for (const QString &subject : subjects) {
+        for (const QString &verb : verbs) {
+            for (const QString &object : objects) {
+                corpus.append(QString("%1 %2 %3.").arg(subject, verb, object));
+            }
+        }
+    }
+    return corpus;
+}
+
+void TestFuzzyIndex::findMatchesBruteForce()
+{
+    // 前缀过滤只是剪枝，结果必须与逐条计算相似度的最大值一致
+    const QStringList corpus = sampleCorpus();
+    FuzzyIndex index;
+    for (const QString &text : corpus) {
+        index.add(text);
+    }
+
+    const QStringList queries = QStringList() << "The knight found a rusty sword!" << "A merchant sold the golden keys."
+                                              << "Your companion is looking for a map of the southern caves"
+                                              << "The young wizard lost two healing potions." << "Something else entirely";
+    const QList<double> thresholds = QList<double>() << 0.3 << 0.5 << 0.7 << 0.85 << 0.95;
+    for (const QString &query : queries) {
+        double expected = 0.0;
+        for (const QString &text : corpus) {
+            expected = qMax(expected, jaccard(query, text));
+        }
+        for (double threshold : thresholds) {
+            const FuzzyIndex::Match match = index.find(query, threshold);
+            const QString context = QString("%1 @ %2").arg(query).arg(threshold);
+            if (expected >= threshold) {
+                QVERIFY2(match.id >= 0, qPrintable(context));
+                QVERIFY2(qFuzzyCompare(match.similarity, expected), qPrintable(context));
+                QVERIFY2(qFuzzyCompare(jaccard(query, index.text(match.id)), expected), qPrintable(context));
+            } else {
+                QVERIFY2(match.id < 0, qPrintable(context));
+            }
+        }
+    }
+}
+
+void TestFuzzyIndex::findAtThreshold()
+{
+    // 相似度恰好等于阈值的记录也在前缀过滤的范围内，其余记录让共有三元组的倒排表变长排到后面
+    const QString query("Open the treasure chest");
+    const QString target("Open the treasure chests now");
+    const double threshold = jaccard(query, target);
+
+    FuzzyIndex index;
+    for (int i = 0; i < 50; ++i) {
+        index.add(QString("the treasure %1").arg(QChar('a' + i % 26)));
+    }
+    const int targetId = index.add(target);
+
+    const FuzzyIndex::Match match = index.find(query, threshold);
+    QCOMPARE(match.id, targetId);
+    QCOMPARE(match.similarity, threshold);
+    QCOMPARE(index.find(query, threshold + 0.01).id, -1);
+}
+
+QTEST_GUILESS_MAIN(TestFuzzyIndex)
+
+#include "tst_fuzzyindex.moc"
@@ -0,0 +1,106 @@
+﻿#include <QtTest>
+
+#include "textnormalizer.h"
+
+// 占位符保护：遮蔽、还原和是否需要翻译的判断
+class TestTextNormalizer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void mask_data();
+    void mask();
+    void restoreReorderedTokens();
+    void restoreFullWidthTokens();
+    void restoreMissingToken();
+    void needsTranslation_data();
+    void needsTranslation();
+};
+
+void TestTextNormalizer::mask_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("masked");
+    QTest::addColumn<QStringList>("placeholders");
+
+    QTest::newRow("godot and printf") << "Hello {name}, you have %d coins" << "Hello {0}, you have {1} coins"
+                                      << (QStringList() << "{name}" << "%d");
+    QTest::newRow("positional printf") << "%1$s and %2$s" << "{0} and {1}" << (QStringList() << "%1$s" << "%2$s");
+    QTest::newRow("percent sign") << "Progress: %d%%" << "Progress: {0}{1}" << (QStringList() << "%d" << "%%");
+    QTest::newRow("bbcode") << "[color=red]Warning[/color]" << "{0}Warning{1}"
+                            << (QStringList() << "[color=red]" << "[/color]");
+    QTest::newRow("bbcode font_size") << "[font_size=20]Big[/font_size]" << "{0}Big{1}"
+                                      << (QStringList() << "[font_size=20]" << "[/font_size]");
+    QTest::newRow("percent before word") << "50%off today" << "50%off today" << QStringList();
+    QTest::newRow("key name in brackets") << "Press [Enter] to continue" << "Press [Enter] to continue" << QStringList();
+    QTest::newRow("unknown tag") << "[b]Bold[/b] [bold]" << "{0}Bold{1} [bold]" << (QStringList() << "[b]" << "[/b]");
+    QTest::newRow("whitespace") << "  a\t\tb  {x} " << "a b {0}" << (QStringList() << "{x}");
+}
+
+void TestTextNormalizer::mask()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, masked);
+    QFETCH(QStringList, placeholders);
+
+    const TextNormalizer::MaskedText result = TextNormalizer::mask(text);
+    QCOMPARE(result.text, masked);
+    QCOMPARE(result.placeholders, placeholders);
+}
+
+void TestTextNormalizer::restoreReorderedTokens()
+{
+    // 译文语序不同，编号的顺序与原文相反
+    const TextNormalizer::MaskedText masked = TextNormalizer::mask("{name} has %d coins");
+    QString translation = QString::fromUtf8(u8"{1}枚金币属于{0}");
+    QVERIFY(TextNormalizer::restore(&translation, masked.placeholders));
+    QCOMPARE(translation, QString::fromUtf8(u8"%d枚金币属于{name}"));
+}
+
+void TestTextNormalizer::restoreFullWidthTokens()
+{
+    // 接口把编号改成全角括号或在括号内加空格
+    const QStringList placeholders = QStringList() << "{name}" << "[b]" << "[/b]";
+    QString translation = QString::fromUtf8(u8"你好｛0｝，{ 1 }欢迎｛ 2 ｝");
+    QVERIFY(TextNormalizer::restore(&translation, placeholders));
+    QCOMPARE(translation, QString::fromUtf8(u8"你好{name}，[b]欢迎[/b]"));
+}
+
+void TestTextNormalizer::restoreMissingToken()
+{
+    const QStringList placeholders = QStringList() << "{name}" << "%d";
+    QString translation = QString::fromUtf8(u8"你好{0}");
+    QVERIFY(!TextNormalizer::restore(&translation, placeholders));
+    QCOMPARE(translation, QString::fromUtf8(u8"你好{name}"));
+
+    // 超出范围的编号不是占位符，保持原样
+    translation = QString::fromUtf8(u8"{0}{1}{7}");
+    QVERIFY(TextNormalizer::restore(&translation, placeholders));
+    QCOMPARE(translation, QString("{name}%d{7}"));
+}
+
+void TestTextNormalizer::needsTranslation_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<bool>("expected");
+
+    QTest::newRow("placeholders only") << "{a}/{b}" << false;
+    QTest::newRow("format and percent") << "%d%%" << false;
+    QTest::newRow("numbers and symbols") << "123 - 456" << false;
+    QTest::newRow("bbcode around number") << "[b]42[/b]" << false;
+    QTest::newRow("word with placeholder") << "{count} coins" << true;
+    QTest::newRow("percent before word") << "50%off" << true;
+    QTest::newRow("key name in brackets") << "[Enter]" << true;
+}
+
+void TestTextNormalizer::needsTranslation()
+{
+    QFETCH(QString, text);
+    QFETCH(bool, expected);
+
+    QCOMPARE(TextNormalizer::needsTranslation(TextNormalizer::mask(text).text), expected);
+}
+
+QTEST_GUILESS_MAIN(TestTextNormalizer)
+
+#include "tst_textnormalizer.moc"
@@ -0,0 +1,103 @@
+﻿#include "textnormalizer.h"
+
+#include <QRegularExpression>
+#include <QVector>
+
+namespace {
+
+// Godot的{name}/{0}/{}、printf的%s/%5.2f/%1$d/%%、BBCode的[b]、[color=red]、[/color]、[url=...]
+// 格式符后紧跟字母时不是格式符("50%off")，方括号只认RichTextLabel支持的标签名("[Enter]"是正文)
+const QRegularExpression &placeholderPattern()
+{
+    static const QRegularExpression pattern(QStringLiteral(
+        "\\{[A-Za-z0-9_.:]*\\}"
+        "|%(?:\\d+\\$)?[-+#0]*\\d*(?:\\.\\d+)?[sdifuxXoeEgGc](?![A-Za-z])"
+        "|%%"
+        "|\\[/?(?:b|i|u|s|p|code|center|left|right|fill|indent|url|hint|img|font|font_size|opentype_features"
+        "|outline_size|outline_color|color|bgcolor|fgcolor|table|cell|ul|ol|lb|rb|wave|tornado|shake|fade"
+        "|rainbow|pulse|dropcap)(?:=[^\\[\\]\\n]*)?(?:\\s[^\\[\\]\\n]*)?\\]"));
+    return pattern;
+}
+
+// 接口可能把{0}改成{ 0 }或全角的｛0｝
+const QRegularExpression &tokenPattern()
+{
+    static const QRegularExpression pattern(QStringLiteral("[{\\x{FF5B}]\\s*(\\d+)\\s*[}\\x{FF5D}]"));
+    return pattern;
+}
+
+const QRegularExpression &horizontalSpacePattern()
+{
+    static const QRegularExpression pattern(QStringLiteral("[ \\t\\x{00A0}\\x{3000}]{2,}|[\\t\\x{00A0}]"));
+    return pattern;
+}
+
+} // namespace
+
+QString TextNormalizer::normalize(const QString &text)
+{
+    QString result = text.normalized(QString::NormalizationForm_C);
+    result.replace(QStringLiteral("\r\n"), QStringLiteral("\n"));
+    result.replace(QLatin1Char('\r'), QLatin1Char('\n'));
+    result.replace(horizontalSpacePattern(), QStringLiteral(" "));
+    return result.trimmed();
+}
+
+TextNormalizer::MaskedText TextNormalizer::mask(const QString &text)
+{
+    MaskedText masked;
+    const QString normalized = normalize(text);
+    QRegularExpressionMatchIterator it = placeholderPattern().globalMatch(normalized);
+    if (!it.hasNext()) {
+        masked.text = normalized;
+        return masked;
+    }
+
+    int last = 0;
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        masked.text += normalized.midRef(last, match.capturedStart() - last);
+        masked.text += QString("{%1}").arg(masked.placeholders.size());
+        masked.placeholders.append(match.captured());
+        last = match.capturedEnd();
+    }
+    masked.text += normalized.midRef(last);
+    return masked;
+}
+
+bool TextNormalizer::restore(QString *text, const QStringList &placeholders)
+{
+    if (placeholders.isEmpty()) {
+        return true;
+    }
+
+    QVector<bool> used(placeholders.size(), false);
+    QString result;
+    int last = 0;
+    QRegularExpressionMatchIterator it = tokenPattern().globalMatch(*text);
+    while (it.hasNext()) {
+        const QRegularExpressionMatch match = it.next();
+        const int index = match.captured(1).toInt();
+        if (index >= placeholders.size()) {
+            continue;
+        }
+        result += text->midRef(last, match.capturedStart() - last);
+        result += placeholders[index];
+        used[index] = true;
+        last = match.capturedEnd();
+    }
+    result += text->midRef(last);
+    *text = result;
+    return !used.contains(false);
+}
+
+bool TextNormalizer::needsTranslation(const QString &maskedText)
+{
+    const QString text = QString(maskedText).remove(tokenPattern());
+    for (const QChar &c : text) {
+        if (c.isLetter()) {
+            return true;
+        }
+    }
+    return false;
+}
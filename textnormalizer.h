@@ -0,0 +1,33 @@
+#ifndef TEXTNORMALIZER_H
+#define TEXTNORMALIZER_H
+
+#include <QString>
+#include <QStringList>
+
+// 源文本的预处理：统一空白和Unicode形式，把占位符和BBCode标签替换成按顺序编号的{0}、{1}...
+// 只有占位符名称或标签不同的文本得到相同的模板，缓存和去重时只请求一次；
+// 接口只看到编号，不会改写占位符，翻译后再按各行自己的占位符还原
+class TextNormalizer
+{
+public:
+    struct MaskedText
+    {
+        QString text;              // 用于缓存、去重和发送的模板
+        QStringList placeholders;  // 按出现顺序被替换的原始内容，第i个对应{i}
+    };
+
+    // 去掉首尾空白，统一换行符，连续的空格和制表符合并为一个空格，转为NFC形式
+    static QString normalize(const QString &text);
+
+    // 先normalize再替换Godot的{name}、printf的%d/%s等格式符和[color=red]等BBCode标签
+    static MaskedText mask(const QString &text);
+
+    // 把译文中的编号换回placeholders，容忍接口在编号内加入的空格和全角括号
+    // 有占位符在译文中丢失时返回false，此时text中未还原的部分保持原样
+    static bool restore(QString *text, const QStringList &placeholders);
+
+    // 模板去掉编号后不含文字(如"{0}/{1}"、"%d%%")时无需翻译，直接使用原文
+    static bool needsTranslation(const QString &maskedText);
+};
+
+#endif // TEXTNORMALIZER_H
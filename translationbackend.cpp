@@ -0,0 +1,32 @@
+#include "translationbackend.h"
+#include "baidubackend.h"
+
+QSharedPointer<TranslationBackend> TranslationBackend::create(const TranslationAccount &account)
+{
+    if (account.provider.isEmpty() || account.provider == "baidu") {
+        QUrl endpoint = account.endpoint.isEmpty() ? QUrl(QString::fromLatin1(kBaiduDefaultEndpoint)) : account.endpoint;
+        return QSharedPointer<TranslationBackend>(new BaiduBackend(account.appId, account.secretKey, endpoint));
+    }
+    return QSharedPointer<TranslationBackend>();
+}
+
+QVector<TranslationAccount> TranslationBackend::loadAccounts(QSettings *settings)
+{
+    QVector<TranslationAccount> accounts;
+    int size = settings->beginReadArray("accounts");
+    for (int i = 0; i < size; ++i) {
+        settings->setArrayIndex(i);
+        TranslationAccount account;
+        account.provider = settings->value("provider", "baidu").toString();
+        account.appId = settings->value("appId").toString().trimmed();
+        account.secretKey = settings->value("secretKey").toString().trimmed();
+        account.endpoint = QUrl(settings->value("endpoint").toString());
+        account.qps = settings->value("qps", 1.0).toDouble();
+        account.burst = settings->value("burst", 1).toInt();
+        if (!account.appId.isEmpty() && !account.secretKey.isEmpty()) {
+            accounts.append(account);
+        }
+    }
+    settings->endArray();
+    return accounts;
+}
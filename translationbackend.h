@@ -0,0 +1,60 @@
+#ifndef TRANSLATIONBACKEND_H
+#define TRANSLATIONBACKEND_H
+
+#include <QByteArray>
+#include <QNetworkRequest>
+#include <QSettings>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+#include "retrypolicy.h"
+
+// 一个翻译账号的配置，来自界面或config.ini中的accounts数组
+struct TranslationAccount
+{
+    QString provider = "baidu";
+    QString appId;
+    QString secretKey;
+    QUrl endpoint;      // 为空时使用服务商的默认地址
+    double qps = 1.0;   // 该账号的每秒请求数上限
+    int burst = 1;
+};
+
+// 翻译服务接口：负责构建和签名请求、声明合并请求的上限并解析响应
+// 离线引擎可以通过本地HTTP服务接入
+class TranslationBackend
+{
+public:
+    virtual ~TranslationBackend() {}
+
+    // 日志中显示的名称，不包含密钥
+    virtual QString name() const = 0;
+
+    // 请求发往的地址，用于提前建立连接
+    virtual QUrl endpoint() const = 0;
+
+    // 多条文本以换行合并为一次请求时的最大字节数，0表示不支持合并
+    virtual int maxBatchBytes() const = 0;
+
+    // 构建请求，text中的多条文本已用换行拼接
+    virtual QNetworkRequest buildRequest(const QString &text, const QString &from, const QString &to,
+                                         QByteArray *body) const = 0;
+
+    // 解析响应，sources和results按段一一对应；失败时返回false并给出错误码和错误信息，
+    // 响应格式不对时错误码为空
+    virtual bool decodeReply(const QByteArray &data, QStringList *sources, QStringList *results,
+                             QString *errorCode, QString *errorMessage) const = 0;
+
+    // 接口错误码对应的处理方式
+    virtual RetryAction classifyError(const QString &errorCode) const = 0;
+
+    // 根据账号的provider创建对应的实现，不支持时返回空指针
+    static QSharedPointer<TranslationBackend> create(const TranslationAccount &account);
+
+    // 读取config.ini中[accounts]数组配置的额外账号
+    static QVector<TranslationAccount> loadAccounts(QSettings *settings);
+};
+
+#endif // TRANSLATIONBACKEND_H
@@ -0,0 +1,661 @@
+﻿#include "translationcli.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSettings>
+#include <QTimer>
+#include <QUrl>
+#include <algorithm>
+#include "csvio.h"
+#include "fuzzyindex.h"
+#include "metricsregistry.h"
+
+namespace {
+
+// 相似查询基准：合成记忆库的条数、查询次数和阈值(开启相似匹配时常用的阈值)
+const int kFuzzyBenchmarkEntries = 200000;
+const int kFuzzyBenchmarkQueries = 2000;
+const double kFuzzyBenchmarkThreshold = 0.9;
+
+struct FuzzyBenchmarkResult
+{
+    qint64 buildMs = 0;
+    qint64 memoryBytes = 0;
+    double p50Us = 0.0;
+    double p99Us = 0.0;
+    int matched = 0;
+};
+
+// 从5000个随机字母组成的词中取5~12个，约四分之一带一个数字
+QString syntheticSentence(QRandomGenerator *random, const QStringList &vocabulary)
+{
+    QStringList words;
+    const int wordCount = random->bounded(5, 13);
+    for (int i = 0; i < wordCount; ++i) {
+        words.append(vocabulary[random->bounded(vocabulary.size())]);
+    }
+    if (random->bounded(4) == 0) {
+        words.insert(random->bounded(words.size() + 1), QString::number(random->bounded(1000)));
+    }
+    return words.join(' ');
+}
+
+FuzzyBenchmarkResult runFuzzyBenchmark()
+{
+    // 固定种子，每次运行使用相同的数据
+    QRandomGenerator random(20240601);
+    FuzzyBenchmarkResult result;
+    FuzzyIndex index;
+
+    QStringList vocabulary;
+    for (int i = 0; i < 5000; ++i) {
+        QString word;
+        const int length = random.bounded(2, 11);
+        for (int j = 0; j < length; ++j) {
+            word += QChar('a' + random.bounded(26));
+        }
+        vocabulary.append(word);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < kFuzzyBenchmarkEntries; ++i) {
+        index.add(syntheticSentence(&random, vocabulary));
+    }
+    result.buildMs = timer.elapsed();
+    result.memoryBytes = index.memoryBytes();
+
+    // 一半查询是已有条目中的一个词加上s(类似单复数的差别)，一半是新句子(找不到)
+    QVector<qint64> durations;
+    durations.reserve(kFuzzyBenchmarkQueries);
+    for (int i = 0; i < kFuzzyBenchmarkQueries; ++i) {
+        QString query;
+        if (i % 2 == 0) {
+            QStringList words = index.text(random.bounded(index.size())).split(' ');
+            words[random.bounded(words.size())] += QLatin1Char('s');
+            query = words.join(' ');
+        } else {
+            query = syntheticSentence(&random, vocabulary);
+        }
+
+        timer.restart();
+        const FuzzyIndex::Match match = index.find(query, kFuzzyBenchmarkThreshold);
+        durations.append(timer.nsecsElapsed());
+        if (match.id >= 0) {
+            result.matched++;
+        }
+    }
+    std::sort(durations.begin(), durations.end());
+    result.p50Us = durations[(durations.size() - 1) * 50 / 100] / 1000.0;
+    result.p99Us = durations[(durations.size() - 1) * 99 / 100] / 1000.0;
+    return result;
+}
+
+// 命令行中的配置优先，其次是环境变量，最后是图形界面保存的config.ini
+QString resolveValue(const QCommandLineParser &parser, const QString &option, const char *envName,
+                     const QSettings &settings, const QString &settingsKey)
+{
+    if (parser.isSet(option)) {
+        return parser.value(option);
+    }
+    QString envValue = qEnvironmentVariable(envName);
+    if (!envValue.isEmpty()) {
+        return envValue;
+    }
+    return settings.value(settingsKey).toString();
+}
+
+} // namespace
+
+TranslationCli::TranslationCli(QObject *parent)
+    : QObject(parent),
+      m_out(stdout, QIODevice::WriteOnly),
+      m_err(stderr, QIODevice::WriteOnly)
+{
+    m_out.setCodec("UTF-8");
+    m_err.setCodec("UTF-8");
+}
+
+TranslationCli::~TranslationCli()
+{
+    // 调度器析构时停止并等待所有工作线程
+    delete m_scheduler;
+}
+
+bool TranslationCli::isRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--cli") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranslationCli::run()
+{
+    int exitCode = parseArguments();
+    if (exitCode != ExitSuccess || !m_scheduler) {
+        finish(exitCode);
+        return;
+    }
+
+    m_lastReport.start();
+    m_scheduler->startTranslation();
+}
+
+int TranslationCli::parseArguments()
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(u8"星火Godot翻译工具 - 命令行批处理模式");
+    QCommandLineOption helpOption = parser.addHelpOption();
+
+    QCommandLineOption cliOption("cli", u8"以命令行批处理模式运行（不显示窗口）");
+    QCommandLineOption inputOption(QStringList() << "i" << "input", u8"要翻译的CSV文件", "file");
+    QCommandLineOption sourceOption(QStringList() << "s" << "source", u8"源语言列名，如en", "column");
+    QCommandLineOption targetsOption(QStringList() << "t" << "targets", u8"目标语言代码，逗号分隔，如jp,kor,fra", "langs");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", u8"输出CSV文件，默认在输入文件名后加时间戳", "file");
+    QCommandLineOption concurrencyOption(QStringList() << "c" << "concurrency", u8"每个账号的最大并发请求数", "n");
+    QCommandLineOption cacheOption("cache", u8"翻译记忆库文件路径", "file");
+    QCommandLineOption appIdOption("appid", u8"百度翻译App Id（或环境变量SPARK_TRANSLATION_APPID）", "id");
+    QCommandLineOption secretOption("secret", u8"百度翻译Secret Key（或环境变量SPARK_TRANSLATION_SECRET）", "key");
+    QCommandLineOption qpsOption("qps", u8"每秒请求数上限", "n");
+    QCommandLineOption burstOption("burst", u8"限速突发数", "n");
+    QCommandLineOption forceOption(QStringList() << "f" << "force", u8"重新翻译已有内容");
+    QCommandLineOption quietOption(QStringList() << "q" << "quiet", u8"只输出进度和错误");
+    QCommandLineOption endpointOption("endpoint", u8"翻译接口地址", "url");
+    QCommandLineOption resumeOption(QStringList() << "r" << "resume", u8"继续上次中断的翻译，跳过翻译日志中已完成的单元格");
+    QCommandLineOption threadsOption("threads", u8"工作线程数，默认按目标语言数自动决定", "n", "0");
+    QCommandLineOption retriesOption("max-retries", u8"临时错误的最大重试次数，默认5", "n");
+    QCommandLineOption fuzzyOption("fuzzy-threshold", u8"翻译记忆库相似匹配的阈值(0~1)，默认0只使用完全相同的原文，常用0.9", "t");
+    QCommandLineOption metricsOption("metrics", u8"运行指标的输出路径(不含扩展名)，写入.json和.prom两个文件，默认写到日志目录", "path");
+    QCommandLineOption accountOption("account", u8"额外的百度翻译账号，可重复指定，格式为appid:secret[:qps[:burst]]", "account");
+    QCommandLineOption benchmarkOption("benchmark", u8"对本地模拟服务器运行吞吐量基准测试");
+    QCommandLineOption benchmarkFuzzyOption("benchmark-fuzzy", u8"用20万条合成记忆库测量相似查询的耗时和索引内存，测完即退出");
+    QCommandLineOption rowsOption("rows", u8"基准测试生成的CSV行数，默认10000", "n", "10000");
+    QCommandLineOption latencyOption("mock-latency", u8"模拟服务器响应延迟(毫秒)，默认50", "ms", "50");
+    QCommandLineOption jitterOption("mock-jitter", u8"模拟服务器延迟的随机波动(毫秒)，默认20", "ms", "20");
+    QCommandLineOption errorRateOption("mock-error-rate", u8"模拟服务器返回错误的概率(0~1)，默认0", "rate", "0");
+    QCommandLineOption mockQpsOption("mock-qps", u8"模拟服务器的QPS上限，默认0不限制", "n", "0");
+    parser.addOptions({ cliOption, inputOption, sourceOption, targetsOption, outputOption, concurrencyOption,
+                        cacheOption, appIdOption, secretOption, qpsOption, burstOption, forceOption, quietOption,
+                        endpointOption, benchmarkOption, benchmarkFuzzyOption, rowsOption, latencyOption, jitterOption, errorRateOption,
+                        mockQpsOption, accountOption, threadsOption, resumeOption, retriesOption,
+                        fuzzyOption, metricsOption });
+
+    if (!parser.parse(QCoreApplication::arguments())) {
+        m_err << parser.errorText() << endl;
+        return ExitUsageError;
+    }
+    if (parser.isSet(helpOption)) {
+        m_out << parser.helpText() << endl;
+        return ExitSuccess;
+    }
+    if (parser.isSet(benchmarkFuzzyOption)) {
+        printFuzzyBenchmarkReport();
+        return ExitSuccess;
+    }
+
+    m_quiet = parser.isSet(quietOption);
+    m_benchmark = parser.isSet(benchmarkOption);
+    QSettings settings("config.ini", QSettings::IniFormat);
+    bool ok = true;
+
+    // 检查必需参数
+    QString inputPath = parser.value(inputOption);
+    QString sourceColumn = parser.value(sourceOption);
+    QStringList targetLangs;
+    for (const QString &lang : parser.value(targetsOption).split(',', QString::SkipEmptyParts)) {
+        targetLangs.append(lang.trimmed());
+    }
+
+    QUrl endpoint(resolveValue(parser, "endpoint", "SPARK_TRANSLATION_ENDPOINT", settings, "api/endpoint"));
+    QString appId = resolveValue(parser, "appid", "SPARK_TRANSLATION_APPID", settings, "api/appId").trimmed();
+    QString secretKey = resolveValue(parser, "secret", "SPARK_TRANSLATION_SECRET", settings, "api/secretKey").trimmed();
+
+    // 基准测试：生成CSV并启动模拟服务器，未指定的参数使用测试默认值
+    if (m_benchmark) {
+        int rows = parser.value(rowsOption).toInt(&ok);
+        if (!ok || rows <= 0) {
+            m_err << u8"行数必须是正整数" << endl;
+            return ExitUsageError;
+        }
+        double errorRate = parser.value(errorRateOption).toDouble(&ok);
+        if (!ok || errorRate < 0 || errorRate > 1) {
+            m_err << u8"错误概率必须在0到1之间" << endl;
+            return ExitUsageError;
+        }
+
+        m_benchmarkDir.reset(new QTemporaryDir());
+        QString errorMessage;
+        if (inputPath.isEmpty()) {
+            inputPath = createBenchmarkInput(rows, &errorMessage);
+            sourceColumn = "en";
+        }
+        if (inputPath.isEmpty()) {
+            m_err << u8"生成基准测试CSV失败: " << errorMessage << endl;
+            return ExitInputError;
+        }
+        if (targetLangs.isEmpty()) {
+            targetLangs << "zh" << "jp";
+        }
+
+        m_mockServer = new MockBaiduServer(this);
+        m_mockServer->setLatency(parser.value(latencyOption).toInt(), parser.value(jitterOption).toInt());
+        m_mockServer->setErrorRate(errorRate);
+        m_mockServer->setQpsLimit(parser.value(mockQpsOption).toInt());
+        if (!m_mockServer->start()) {
+            m_err << u8"启动模拟服务器失败: " << m_mockServer->errorString() << endl;
+            return ExitUsageError;
+        }
+        endpoint = m_mockServer->endpoint();
+        appId = "benchmark";
+        secretKey = "benchmark";
+    }
+
+    if (inputPath.isEmpty() || sourceColumn.isEmpty() || targetLangs.isEmpty()) {
+        m_err << u8"缺少必需参数: --input、--source和--targets" << endl << endl << parser.helpText() << endl;
+        return ExitUsageError;
+    }
+
+    int concurrency = parser.isSet(concurrencyOption) ? parser.value(concurrencyOption).toInt(&ok)
+                                                      : settings.value("settings/maxConcurrent", 4).toInt();
+    if (!ok || concurrency <= 0) {
+        m_err << u8"并发请求数必须是正整数" << endl;
+        return ExitUsageError;
+    }
+    int workerCount = parser.isSet(threadsOption) ? parser.value(threadsOption).toInt(&ok)
+                                                  : settings.value("settings/workerThreads", 0).toInt();
+    if (!ok || workerCount < 0) {
+        m_err << u8"工作线程数必须是非负整数" << endl;
+        return ExitUsageError;
+    }
+    int maxRetries = parser.isSet(retriesOption) ? parser.value(retriesOption).toInt(&ok)
+                                                 : settings.value("settings/maxRetries", 5).toInt();
+    if (!ok || maxRetries <= 0) {
+        m_err << u8"最大重试次数必须是正整数" << endl;
+        return ExitUsageError;
+    }
+    // 基准测试的文本大多只有编号不同，默认不做相似匹配
+    double fuzzyThreshold = parser.isSet(fuzzyOption) ? parser.value(fuzzyOption).toDouble(&ok)
+                                                      : (m_benchmark ? 0.0 : settings.value("settings/fuzzyThreshold", 0.0).toDouble());
+    if (!ok || fuzzyThreshold < 0 || fuzzyThreshold > 1) {
+        m_err << u8"相似匹配阈值必须在0到1之间" << endl;
+        return ExitUsageError;
+    }
+    // 基准测试默认不在客户端限速，由模拟服务器的QPS上限决定
+    double qps = parser.isSet(qpsOption) ? parser.value(qpsOption).toDouble(&ok)
+                                         : (m_benchmark ? 100000.0 : settings.value("settings/qps", 1.0).toDouble());
+    if (!ok || qps <= 0) {
+        m_err << u8"每秒请求数必须大于0" << endl;
+        return ExitUsageError;
+    }
+    int burst = parser.isSet(burstOption) ? parser.value(burstOption).toInt(&ok)
+                                          : (m_benchmark ? concurrency : settings.value("settings/burst", 1).toInt());
+    if (!ok || burst <= 0) {
+        m_err << u8"突发数必须是正整数" << endl;
+        return ExitUsageError;
+    }
+
+    // 主账号使用--appid/--secret/--qps/--burst，--account和config.ini的accounts数组可添加更多账号分担请求
+    QVector<TranslationAccount> accounts;
+    if (!appId.isEmpty() && !secretKey.isEmpty()) {
+        TranslationAccount account;
+        account.appId = appId;
+        account.secretKey = secretKey;
+        account.endpoint = endpoint;
+        account.qps = qps;
+        account.burst = burst;
+        accounts.append(account);
+    }
+    for (const QString &value : parser.values(accountOption)) {
+        QStringList parts = value.split(':');
+        if (parts.size() < 2 || parts.size() > 4 || parts[0].isEmpty() || parts[1].isEmpty()) {
+            m_err << u8"账号格式应为appid:secret[:qps[:burst]]: " << value << endl;
+            return ExitUsageError;
+        }
+        TranslationAccount account;
+        account.appId = parts[0];
+        account.secretKey = parts[1];
+        account.endpoint = endpoint;
+        account.qps = parts.size() > 2 ? parts[2].toDouble(&ok) : qps;
+        bool burstOk = true;
+        account.burst = parts.size() > 3 ? parts[3].toInt(&burstOk) : burst;
+        if (!ok || !burstOk || account.qps <= 0 || account.burst <= 0) {
+            m_err << u8"账号的每秒请求数和突发数必须大于0: " << value << endl;
+            return ExitUsageError;
+        }
+        accounts.append(account);
+    }
+    if (!m_benchmark) {
+        accounts += TranslationBackend::loadAccounts(&settings);
+    }
+    if (accounts.isEmpty()) {
+        m_err << u8"缺少百度翻译API配置，请使用--appid/--secret、--account或环境变量指定" << endl;
+        return ExitUsageError;
+    }
+
+    // 加载CSV
+    QString errorMessage;
+    if (!m_table.load(inputPath, &errorMessage) || m_table.isEmpty()) {
+        m_err << u8"加载CSV文件失败: " << inputPath << " " << errorMessage << endl;
+        return ExitInputError;
+    }
+    int sourceColumnIndex = m_table.columnIndex(sourceColumn);
+    if (sourceColumnIndex == -1) {
+        m_err << u8"源语言列不存在: " << sourceColumn << endl;
+        return ExitInputError;
+    }
+    m_sourceColumnIndex = sourceColumnIndex;
+    if (!m_manifest.load(TranslationManifest::pathFor(inputPath), &errorMessage)) {
+        m_err << u8"无法读取翻译清单，将只按译文是否为空判断: " << errorMessage << endl;
+    }
+
+    m_outputPath = parser.value(outputOption);
+    if (m_outputPath.isEmpty() && m_benchmark) {
+        m_outputPath = m_benchmarkDir->filePath("benchmark_out.csv");
+    } else if (m_outputPath.isEmpty()) {
+        QString timestamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss");
+        m_outputPath = inputPath;
+        m_outputPath.replace(".csv", QString("_%1.csv").arg(timestamp), Qt::CaseInsensitive);
+    }
+
+    // 基准测试默认使用空的翻译记忆库，指定--cache时可测量命中缓存的情况
+    QString memoryPath = parser.isSet(cacheOption) ? parser.value(cacheOption)
+                       : m_benchmark ? m_benchmarkDir->filePath("benchmark_memory.tm")
+                       : settings.value("settings/memoryPath", TranslationMemory::defaultFilePath()).toString();
+    m_translationMemory.reset(new TranslationMemory(memoryPath));
+
+    // 翻译日志记录每个完成的单元格，--resume时先恢复上次的结果
+    QHash<QString, QBitArray> resumedRows;
+    m_journal.reset(new TranslationJournal(TranslationJournal::pathFor(inputPath)));
+    QVector<TranslationResult> journalEntries;
+    QVector<TranslationReview> journalReviews;
+    if (!m_journal->open(TranslationJournal::fingerprint(inputPath, sourceColumn), &journalEntries, &journalReviews,
+                         &errorMessage)) {
+        m_err << u8"无法打开翻译日志，本次翻译中断后将无法继续: " << errorMessage << endl;
+        m_journal.reset();
+    } else if (!journalEntries.isEmpty() && parser.isSet(resumeOption)) {
+        applyResults(journalEntries);
+        for (const TranslationResult &result : journalEntries) {
+            QBitArray &rows = resumedRows[result.targetLang];
+            if (rows.isEmpty()) {
+                rows.resize(m_table.rowCount());
+            }
+            if (result.row >= 0 && result.row < rows.size()) {
+                rows.setBit(result.row);
+            }
+        }
+        m_out << QString(u8"已从翻译日志恢复%1个单元格").arg(journalEntries.size()) << endl;
+    } else if (!journalEntries.isEmpty()) {
+        m_journal->reset();
+        journalReviews.clear();
+        m_out << QString(u8"已丢弃上次未完成的翻译记录(%1个单元格)，使用--resume可以继续上次的翻译").arg(journalEntries.size()) << endl;
+    }
+
+    // 创建翻译调度器
+    m_scheduler = new TranslationScheduler(this);
+
+    for (const TranslationAccount &account : accounts) {
+        QSharedPointer<TranslationBackend> backend = TranslationBackend::create(account);
+        if (!backend) {
+            m_err << u8"不支持的翻译接口: " << account.provider << endl;
+            return ExitUsageError;
+        }
+        m_scheduler->addBackend(backend, QSharedPointer<RateLimiter>(new RateLimiter(account.qps, account.burst)));
+    }
+    // 强制重新翻译时也跳过本次任务日志中已完成的单元格
+    m_scheduler->setTranslationData(m_table.column(sourceColumnIndex), "auto", targetLangs, false);
+    if (parser.isSet(forceOption)) {
+        m_scheduler->setTranslatedRows(resumedRows);
+    } else {
+        int staleCount = 0;
+        int reviewCount = 0;
+        m_scheduler->setTranslatedRows(m_manifest.upToDateRows(m_table, sourceColumnIndex, targetLangs,
+                                                               &staleCount, &reviewCount));
+        if (staleCount > 0) {
+            m_out << QString(u8"原文已修改，%1个单元格的译文将重新翻译").arg(staleCount) << endl;
+        }
+        if (reviewCount > 0) {
+            m_out << QString(u8"%1个单元格仍是未经审核的相似译文，将重新翻译").arg(reviewCount) << endl;
+        }
+    }
+    // 从日志恢复的相似译文本次不再重新翻译，计算完需要翻译的行之后再记为待审核
+    applyReviews(journalReviews);
+    m_scheduler->setTranslationMemory(m_translationMemory);
+    m_scheduler->setMaxConcurrent(concurrency);
+    m_scheduler->setMaxBatchBytes(settings.value("settings/batchBytes", kDefaultMaxBatchBytes).toInt());
+    m_scheduler->setWorkerCount(workerCount);
+    m_scheduler->setRetryPolicy(RetryPolicy(maxRetries));
+    m_scheduler->setFuzzyThreshold(fuzzyThreshold);
+    m_scheduler->setMetricsPath(parser.value(metricsOption));
+
+    connect(m_scheduler, &TranslationScheduler::progressUpdated, this, &TranslationCli::onProgress);
+    connect(m_scheduler, &TranslationScheduler::translationFinished, this, &TranslationCli::onFinished);
+    connect(m_scheduler, &TranslationScheduler::translationError, this, &TranslationCli::onError);
+    connect(m_scheduler, &TranslationScheduler::logMessage, this, &TranslationCli::onLogMessage);
+
+    m_out << QString(u8"输入: %1 (%2行)，源语言列: %3，目标语言: %4")
+             .arg(inputPath).arg(m_table.rowCount()).arg(sourceColumn, targetLangs.join(',')) << endl;
+    return ExitSuccess;
+}
+
+QString TranslationCli::createBenchmarkInput(int rows, QString *errorMessage)
+{
+    if (!m_benchmarkDir->isValid()) {
+        *errorMessage = m_benchmarkDir->errorString();
+        return QString();
+    }
+
+    QString path = m_benchmarkDir->filePath("benchmark.csv");
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        *errorMessage = file.errorString();
+        return QString();
+    }
+
+    // 长短不一的文本，约五分之一的行与前面的行重复，接近真实游戏文本中的重复比例
+    CsvWriter writer(&file);
+    writer.writeRow(QStringList() << "keys" << "en");
+    for (int i = 0; i < rows; ++i) {
+        int id = (i % 5 == 4) ? i / 2 : i;
+        QString text = QString("Item %1: The quick brown fox jumps over the lazy dog").arg(id);
+        if (id % 3 == 0) {
+            text += QString(", then rests near the river bank for %1 minutes").arg(id % 60);
+        }
+        writer.writeRow(QStringList() << QString("KEY_%1").arg(i) << text);
+    }
+    if (!writer.flush()) {
+        *errorMessage = file.errorString();
+        return QString();
+    }
+    return path;
+}
+
+void TranslationCli::printBenchmarkReport()
+{
+    const TranslationProgress &progress = m_lastProgress;
+    double seconds = qMax<qint64>(1, progress.elapsedMs) / 1000.0;
+
+    QVector<qint64> latencies;
+    QVector<qint64> firstBytes;
+    for (const RequestTiming &timing : m_timings) {
+        latencies.append(timing.totalMs);
+        if (timing.ttfbMs >= 0) {
+            firstBytes.append(timing.ttfbMs);
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::sort(firstBytes.begin(), firstBytes.end());
+    qint64 p50 = latencies.isEmpty() ? 0 : latencies[(latencies.size() - 1) * 50 / 100];
+    qint64 p99 = latencies.isEmpty() ? 0 : latencies[(latencies.size() - 1) * 99 / 100];
+    qint64 ttfbP50 = firstBytes.isEmpty() ? 0 : firstBytes[(firstBytes.size() - 1) * 50 / 100];
+
+    int lookups = progress.cacheHits + progress.requestedTexts;
+    double hitRate = lookups > 0 ? progress.cacheHits * 100.0 / lookups : 0.0;
+
+    m_out << u8"基准测试结果:" << endl
+          << QString(u8"  行数: %1，单元格: %2，耗时: %3秒")
+             .arg(m_table.rowCount()).arg(progress.total).arg(seconds, 0, 'f', 2) << endl
+          << QString(u8"  吞吐量: %1行/秒，%2单元格/秒")
+             .arg(m_table.rowCount() / seconds, 0, 'f', 1).arg(progress.completed / seconds, 0, 'f', 1) << endl
+          << QString(u8"  请求: %1次，%2次/秒，服务器拒绝%3次")
+             .arg(progress.requestCount).arg(progress.requestCount / seconds, 0, 'f', 1)
+             .arg(m_mockServer->rejectedCount()) << endl
+          << QString(u8"  请求延迟: p50 %1毫秒，p99 %2毫秒，首字节p50 %3毫秒").arg(p50).arg(p99).arg(ttfbP50) << endl
+          << QString(u8"  缓存命中率: %1% (%2/%3)").arg(hitRate, 0, 'f', 1).arg(progress.cacheHits).arg(lookups) << endl;
+}
+
+void TranslationCli::printFuzzyBenchmarkReport()
+{
+    // 相似查询与翻译流程无关，单独用合成的大记忆库测量
+    m_out << QString(u8"正在测量相似查询(%1条合成记忆库)...").arg(kFuzzyBenchmarkEntries) << endl;
+    const FuzzyBenchmarkResult fuzzy = runFuzzyBenchmark();
+    m_out << QString(u8"相似查询: 建立索引%1毫秒，约%2MB，%3次查询p50 %4微秒，p99 %5微秒，命中%6次(阈值%7)")
+             .arg(fuzzy.buildMs).arg(fuzzy.memoryBytes / (1024.0 * 1024.0), 0, 'f', 1).arg(kFuzzyBenchmarkQueries)
+             .arg(fuzzy.p50Us, 0, 'f', 1).arg(fuzzy.p99Us, 0, 'f', 1).arg(fuzzy.matched).arg(kFuzzyBenchmarkThreshold)
+          << endl;
+}
+
+void TranslationCli::onProgress(const TranslationProgress &progress)
+{
+    if (m_journal) {
+        m_journal->append(progress.results, progress.reviews);
+    }
+    m_timings += progress.requestTimings;
+    m_failures += progress.failures;
+    m_lastProgress = progress;
+    m_lastProgress.results.clear();
+    m_lastProgress.failures.clear();
+    m_lastProgress.reviews.clear();
+
+    QElapsedTimer applyTimer;
+    applyTimer.start();
+    applyResults(progress.results);
+    applyReviews(progress.reviews);
+    static MetricHistogram *const uiUpdateMetric = MetricsRegistry::instance()->histogram(kMetricUiUpdateDuration);
+    uiUpdateMetric->observe(applyTimer.nsecsElapsed() / 1000000.0);
+
+    // 每秒最多输出一行进度
+    if (m_lastReport.elapsed() < 1000 && progress.completed < progress.total) {
+        return;
+    }
+    m_lastReport.restart();
+
+    double seconds = progress.elapsedMs / 1000.0;
+    m_out << QString(u8"进度 %1/%2 (%3%)，%4条/秒，已请求%5次，并发窗口%6")
+             .arg(progress.completed).arg(progress.total)
+             .arg(progress.total > 0 ? progress.completed * 100 / progress.total : 100)
+             .arg(seconds > 0 ? progress.completed / seconds : 0.0, 0, 'f', 1)
+             .arg(progress.requestCount).arg(progress.concurrencyWindow) << endl;
+}
+
+void TranslationCli::onFinished()
+{
+    QString errorMessage;
+    if (!m_table.save(m_outputPath, &errorMessage)) {
+        m_err << u8"保存文件失败: " << m_outputPath << " " << errorMessage << endl;
+        finish(ExitOutputError);
+        return;
+    }
+
+    m_out << u8"翻译完成，结果已保存到: " << m_outputPath << endl;
+    // 清单同时保存在输入文件旁，结果复制回输入文件后再次翻译时仍能找到
+    QStringList manifestPaths;
+    manifestPaths << TranslationManifest::pathFor(m_table.filePath()) << TranslationManifest::pathFor(m_outputPath);
+    manifestPaths.removeDuplicates();
+    for (const QString &manifestPath : manifestPaths) {
+        if (!m_manifest.save(manifestPath, &errorMessage)) {
+            m_err << u8"保存翻译清单失败: " << manifestPath << " " << errorMessage << endl;
+        }
+    }
+    if (m_journal) {
+        m_journal->remove();
+        m_journal.reset();
+    }
+    if (m_benchmark) {
+        printBenchmarkReport();
+    }
+
+    // 使用相似原文译文的单元格写到输出文件旁，供人工审核
+    if (!m_reviews.isEmpty()) {
+        QString reviewPath = m_outputPath;
+        reviewPath.replace(".csv", QString("_review.csv"), Qt::CaseInsensitive);
+        if (TranslationScheduler::saveReviews(reviewPath, m_reviews, m_table.column(0), &errorMessage)) {
+            m_out << QString(u8"%1个单元格使用了相似原文的译文，待审核列表已保存到: %2").arg(m_reviews.size()).arg(reviewPath) << endl;
+        } else {
+            m_err << QString(u8"%1个单元格使用了相似原文的译文，保存待审核列表出错: %2").arg(m_reviews.size()).arg(errorMessage) << endl;
+        }
+    }
+
+    // 多次重试仍失败的单元格写到输出文件旁，修正后可以只补翻这些内容
+    if (!m_failures.isEmpty()) {
+        QString failurePath = m_outputPath;
+        failurePath.replace(".csv", QString("_failed.csv"), Qt::CaseInsensitive);
+        if (TranslationScheduler::saveFailures(failurePath, m_failures, m_table.column(0), &errorMessage)) {
+            m_err << QString(u8"%1个单元格翻译失败，列表已保存到: %2").arg(m_failures.size()).arg(failurePath) << endl;
+        } else {
+            m_err << QString(u8"%1个单元格翻译失败，保存失败列表出错: %2").arg(m_failures.size()).arg(errorMessage) << endl;
+        }
+        finish(ExitPartialFailure);
+        return;
+    }
+    finish(ExitSuccess);
+}
+
+void TranslationCli::applyResults(const QVector<TranslationResult> &results)
+{
+    for (const TranslationResult &result : results) {
+        int column = m_table.columnIndex(result.targetLang);
+        if (column == -1) {
+            column = m_table.addColumn(result.targetLang);
+        }
+        m_table.setCell(result.row, column, result.text);
+        m_manifest.record(m_table.cell(result.row, 0), result.targetLang,
+                          TranslationManifest::sourceHash(m_table.cell(result.row, m_sourceColumnIndex)));
+    }
+}
+
+void TranslationCli::applyReviews(const QVector<TranslationReview> &reviews)
+{
+    for (const TranslationReview &review : reviews) {
+        int column = m_table.columnIndex(review.targetLang);
+        m_manifest.recordForReview(m_table.cell(review.row, 0), review.targetLang,
+                                   TranslationManifest::sourceHash(m_table.cell(review.row, m_sourceColumnIndex)),
+                                   TranslationManifest::sourceHash(m_table.cell(review.row, column)));
+    }
+    m_reviews += reviews;
+}
+
+void TranslationCli::onError(const QString &error)
+{
+    m_err << u8"翻译错误: " << error << endl;
+    if (m_journal) {
+        m_journal->sync();
+        m_err << u8"已完成的翻译已记录到翻译日志，使用--resume可以继续" << endl;
+    }
+    finish(ExitTranslationError);
+}
+
+void TranslationCli::onLogMessage(const QString &message)
+{
+    if (!m_quiet) {
+        m_err << message << endl;
+    }
+}
+
+void TranslationCli::finish(int exitCode)
+{
+    // 此时可能正处于调度器发出的信号中，工作线程在析构时再回收
+    if (m_scheduler) {
+        m_scheduler->stopTranslation();
+    }
+
+    m_out.flush();
+    m_err.flush();
+    QCoreApplication::exit(exitCode);
+}
@@ -0,0 +1,82 @@
+#ifndef TRANSLATIONCLI_H
+#define TRANSLATIONCLI_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include "csvtable.h"
+#include "mockbaiduserver.h"
+#include "translationjournal.h"
+#include "translationmanifest.h"
+#include "translationscheduler.h"
+
+// 命令行批处理模式：不创建任何窗口，直接驱动TranslationScheduler翻译CSV文件，
+// 供构建服务器在导出Godot项目时调用
+// 加上--benchmark时改为对本地模拟服务器翻译生成的CSV，并输出吞吐量和延迟统计；
+// --benchmark-fuzzy只测量相似查询，不翻译
+class TranslationCli : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 进程退出码
+    enum ExitCode {
+        ExitSuccess = 0,
+        ExitUsageError = 1,
+        ExitInputError = 2,
+        ExitTranslationError = 3,
+        ExitOutputError = 4,
+        ExitPartialFailure = 5  // 翻译完成，但有单元格多次重试后仍失败
+    };
+
+    explicit TranslationCli(QObject *parent = nullptr);
+    ~TranslationCli();
+
+    // 命令行参数中包含--cli时进入批处理模式
+    static bool isRequested(int argc, char *argv[]);
+
+public slots:
+    // 解析参数并开始翻译，结束时调用QCoreApplication::exit()
+    void run();
+
+private slots:
+    void onProgress(const TranslationProgress &progress);
+    void onFinished();
+    void onError(const QString &error);
+    void onLogMessage(const QString &message);
+
+private:
+    int parseArguments();
+    QString createBenchmarkInput(int rows, QString *errorMessage);
+    void printBenchmarkReport();
+    void printFuzzyBenchmarkReport();
+    void finish(int exitCode);
+    // 把结果写入表格并记入翻译清单
+    void applyResults(const QVector<TranslationResult> &results);
+    // 记录使用相似原文译文的单元格，清单中记为待审核，必须在对应的结果写入表格之后调用
+    void applyReviews(const QVector<TranslationReview> &reviews);
+
+    QTextStream m_out;
+    QTextStream m_err;
+    CsvTable m_table;
+    int m_sourceColumnIndex = -1;
+    TranslationManifest m_manifest;
+    QString m_outputPath;
+    TranslationScheduler *m_scheduler = nullptr;
+    QSharedPointer<TranslationMemory> m_translationMemory;
+    QScopedPointer<TranslationJournal> m_journal;
+    QElapsedTimer m_lastReport;
+    bool m_quiet = false;
+    bool m_benchmark = false;
+    MockBaiduServer *m_mockServer = nullptr;
+    QScopedPointer<QTemporaryDir> m_benchmarkDir;
+    QVector<RequestTiming> m_timings;
+    QVector<TranslationFailure> m_failures;
+    QVector<TranslationReview> m_reviews;
+    TranslationProgress m_lastProgress;
+};
+
+#endif // TRANSLATIONCLI_H
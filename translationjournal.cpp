@@ -0,0 +1,259 @@
+﻿#include "translationjournal.h"
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QHash>
+#include <QPair>
+#include <QtEndian>
+#include <QDebug>
+
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kMagic[4] = { 'S', 'G', 'T', 'J' };
+// 版本1的记录没有审核信息，升级后旧日志作废
+const quint32 kVersion = 2;
+const int kRecordHeaderSize = 24;
+
+// 相似度按百万分之一保存
+const double kSimilarityScale = 1000000.0;
+
+// 两次fsync之间的最短间隔，结果每100毫秒到达一批，合并后约每秒落盘一次
+const int kSyncIntervalMs = 1000;
+
+void appendUInt32(QByteArray *data, quint32 value)
+{
+    uchar buffer[4];
+    qToLittleEndian<quint32>(value, buffer);
+    data->append(reinterpret_cast<const char *>(buffer), 4);
+}
+
+// QFile::flush()只把数据交给操作系统，断电时仍可能丢失
+bool syncToDisk(QFile &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle()))) != 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+} // namespace
+
+TranslationJournal::TranslationJournal(const QString &filePath)
+    : m_filePath(filePath)
+{
+}
+
+TranslationJournal::~TranslationJournal()
+{
+    if (m_file.isOpen()) {
+        sync();
+        m_file.close();
+    }
+}
+
+QString TranslationJournal::pathFor(const QString &csvPath)
+{
+    return csvPath + ".journal";
+}
+
+QByteArray TranslationJournal::fingerprint(const QString &csvPath, const QString &sourceColumn)
+{
+    QFileInfo info(csvPath);
+    return QString("%1|%2|%3").arg(info.size()).arg(info.lastModified().toMSecsSinceEpoch()).arg(sourceColumn).toUtf8();
+}
+
+QString TranslationJournal::filePath() const
+{
+    return m_filePath;
+}
+
+bool TranslationJournal::open(const QByteArray &fingerprint, QVector<TranslationResult> *entries,
+                              QVector<TranslationReview> *reviews, QString *errorMessage)
+{
+    m_fingerprint = fingerprint;
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        if (errorMessage) {
+            *errorMessage = m_file.errorString();
+        }
+        return false;
+    }
+    m_lastSync.start();
+
+    qint64 fileSize = m_file.size();
+    uchar *data = fileSize > 0 ? m_file.map(0, fileSize) : nullptr;
+    qint64 offset = 0;
+    bool valid = data && fileSize >= 12 && memcmp(data, kMagic, 4) == 0
+                 && qFromLittleEndian<quint32>(data + 4) == kVersion;
+    if (valid) {
+        quint32 fingerprintLength = qFromLittleEndian<quint32>(data + 8);
+        offset = 12 + fingerprintLength;
+        valid = offset <= fileSize
+                && QByteArray::fromRawData(reinterpret_cast<const char *>(data + 12), int(fingerprintLength)) == fingerprint;
+    }
+
+    if (valid) {
+        while (offset + kRecordHeaderSize <= fileSize) {
+            quint32 row = qFromLittleEndian<quint32>(data + offset);
+            quint32 langLength = qFromLittleEndian<quint32>(data + offset + 4);
+            quint32 textLength = qFromLittleEndian<quint32>(data + offset + 8);
+            quint32 sourceLength = qFromLittleEndian<quint32>(data + offset + 12);
+            quint32 matchedLength = qFromLittleEndian<quint32>(data + offset + 16);
+            quint32 similarity = qFromLittleEndian<quint32>(data + offset + 20);
+            qint64 recordEnd = offset + kRecordHeaderSize + qint64(langLength) + textLength + sourceLength + matchedLength;
+            if (recordEnd > fileSize) {
+                break;
+            }
+
+            const char *fields = reinterpret_cast<const char *>(data + offset + kRecordHeaderSize);
+            TranslationResult result;
+            result.row = int(row);
+            result.targetLang = QString::fromUtf8(fields, int(langLength));
+            result.text = QString::fromUtf8(fields + langLength, int(textLength));
+            entries->append(result);
+            if (similarity > 0) {
+                const char *reviewFields = fields + langLength + textLength;
+                TranslationReview review;
+                review.row = result.row;
+                review.targetLang = result.targetLang;
+                review.sourceText = QString::fromUtf8(reviewFields, int(sourceLength));
+                review.matchedSource = QString::fromUtf8(reviewFields + sourceLength, int(matchedLength));
+                review.similarity = similarity / kSimilarityScale;
+                reviews->append(review);
+            }
+            offset = recordEnd;
+        }
+    }
+    if (data) {
+        m_file.unmap(data);
+    }
+
+    if (!valid) {
+        // 新文件、格式不对或源文件已变化，旧记录不能再用
+        if (fileSize > 0) {
+            qWarning() << u8"翻译日志与当前文件不匹配，已重新创建:" << m_filePath;
+        }
+        entries->clear();
+        reviews->clear();
+        if (!writeHeader()) {
+            if (errorMessage) {
+                *errorMessage = m_file.errorString();
+            }
+            return false;
+        }
+        return true;
+    }
+
+    // 上次异常退出时可能留下写了一半的记录，截断到最后一条完整记录
+    if (offset < fileSize) {
+        qWarning() << u8"翻译日志末尾存在不完整记录，已截断:" << (fileSize - offset) << u8"字节";
+        m_file.resize(offset);
+    }
+    m_file.seek(offset);
+    return true;
+}
+
+void TranslationJournal::reset()
+{
+    if (m_file.isOpen()) {
+        writeHeader();
+    }
+}
+
+void TranslationJournal::append(const QVector<TranslationResult> &results, const QVector<TranslationReview> &reviews)
+{
+    if (!m_file.isOpen() || results.isEmpty()) {
+        return;
+    }
+
+    // 审核信息和结果在同一批进度中到达，按行号和语言对应
+    QHash<QPair<int, QString>, const TranslationReview *> reviewByCell;
+    for (const TranslationReview &review : reviews) {
+        reviewByCell.insert(qMakePair(review.row, review.targetLang), &review);
+    }
+
+    // 整批结果拼成一次写入
+    QByteArray records;
+    for (const TranslationResult &result : results) {
+        const TranslationReview *review = reviewByCell.value(qMakePair(result.row, result.targetLang));
+        QByteArray lang = result.targetLang.toUtf8();
+        QByteArray text = result.text.toUtf8();
+        QByteArray source = review ? review->sourceText.toUtf8() : QByteArray();
+        QByteArray matched = review ? review->matchedSource.toUtf8() : QByteArray();
+        // 相似度不低于阈值，阈值大于0，保存为0的只有普通译文
+        quint32 similarity = review ? qMax<quint32>(1, quint32(qRound(review->similarity * kSimilarityScale))) : 0;
+        appendUInt32(&records, quint32(result.row));
+        appendUInt32(&records, quint32(lang.size()));
+        appendUInt32(&records, quint32(text.size()));
+        appendUInt32(&records, quint32(source.size()));
+        appendUInt32(&records, quint32(matched.size()));
+        appendUInt32(&records, similarity);
+        records.append(lang);
+        records.append(text);
+        records.append(source);
+        records.append(matched);
+    }
+
+    if (m_file.write(records) != records.size()) {
+        qWarning() << u8"写入翻译日志失败:" << m_file.errorString();
+        return;
+    }
+    m_dirty = true;
+
+    if (m_lastSync.elapsed() >= kSyncIntervalMs) {
+        sync();
+    }
+}
+
+bool TranslationJournal::sync()
+{
+    if (!m_file.isOpen() || !m_dirty) {
+        return true;
+    }
+
+    m_lastSync.restart();
+    m_dirty = false;
+    if (!syncToDisk(m_file)) {
+        qWarning() << u8"同步翻译日志失败:" << m_filePath;
+        return false;
+    }
+    return true;
+}
+
+void TranslationJournal::remove()
+{
+    m_file.close();
+    m_dirty = false;
+    QFile::remove(m_filePath);
+}
+
+bool TranslationJournal::writeHeader()
+{
+    QByteArray header(kMagic, 4);
+    appendUInt32(&header, kVersion);
+    appendUInt32(&header, quint32(m_fingerprint.size()));
+    header.append(m_fingerprint);
+
+    m_file.resize(0);
+    m_file.seek(0);
+    if (m_file.write(header) != header.size()) {
+        qWarning() << u8"无法初始化翻译日志:" << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+    m_dirty = true;
+    return sync();
+}
@@ -0,0 +1,53 @@
+#ifndef TRANSLATIONJOURNAL_H
+#define TRANSLATIONJOURNAL_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include "translationworker.h"
+
+// 翻译任务日志：每个单元格的翻译结果一到达就追加写入CSV旁的.journal文件，
+// 程序退出、断网或出错后可以从中恢复，只翻译剩余的单元格
+// 文件格式: "SGTJ" + quint32版本号 + quint32指纹长度 + 指纹，之后每条记录为
+// quint32行号 + quint32语言长度 + quint32译文长度 + quint32原文长度 + quint32相似原文长度 + quint32相似度(百万分之一)
+// + 语言 + 译文 + 原文 + 相似原文(均为UTF-8)；相似度为0表示普通译文，原文和相似原文为空，
+// 否则是使用相似原文译文填写、需要审核的单元格
+// 指纹记录源文件的大小、修改时间和源语言列，源文件变化后旧日志作废
+class TranslationJournal
+{
+public:
+    explicit TranslationJournal(const QString &filePath);
+    ~TranslationJournal();
+
+    static QString pathFor(const QString &csvPath);
+    static QByteArray fingerprint(const QString &csvPath, const QString &sourceColumn);
+
+    QString filePath() const;
+
+    // 打开或创建日志，指纹一致时读出上次记录的结果和其中需要审核的单元格，否则清空重建
+    bool open(const QByteArray &fingerprint, QVector<TranslationResult> *entries, QVector<TranslationReview> *reviews,
+              QString *errorMessage = nullptr);
+
+    // 丢弃已有记录，重新开始
+    void reset();
+
+    // 追加一批结果，reviews中的单元格记录为需要审核，写入后最多每秒同步一次到磁盘
+    void append(const QVector<TranslationResult> &results, const QVector<TranslationReview> &reviews);
+    bool sync();
+
+    // 翻译结果已保存后删除日志
+    void remove();
+
+private:
+    bool writeHeader();
+
+    QString m_filePath;
+    QFile m_file;
+    QByteArray m_fingerprint;
+    QElapsedTimer m_lastSync;
+    bool m_dirty = false;
+};
+
+#endif // TRANSLATIONJOURNAL_H
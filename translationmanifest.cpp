@@ -0,0 +1,172 @@
+﻿#include "translationmanifest.h"
+
+#include <QFile>
+#include "csvio.h"
+
+namespace {
+
+// 表格第一列是Godot的翻译键
+const int kKeyColumn = 0;
+
+} // namespace
+
+QString TranslationManifest::pathFor(const QString &csvPath)
+{
+    return csvPath + ".manifest";
+}
+
+quint64 TranslationManifest::sourceHash(const QString &text)
+{
+    const QByteArray data = text.trimmed().toUtf8();
+    quint64 hash = 14695981039346656037ULL;
+    for (char c : data) {
+        hash ^= quint8(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool TranslationManifest::load(const QString &filePath, QString *errorMessage)
+{
+    m_entries.clear();
+
+    QFile file(filePath);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+
+    CsvReader reader(&file);
+    QStringList row;
+    bool header = true;
+    while (reader.readRow(&row)) {
+        if (header) {
+            header = false;
+            continue;
+        }
+        if (row.size() < 3) {
+            continue;
+        }
+        bool ok = false;
+        Entry entry;
+        entry.sourceHash = row[2].toULongLong(&ok, 16);
+        if (!ok) {
+            continue;
+        }
+        // 旧版清单没有review列
+        if (row.size() > 3 && !row[3].isEmpty()) {
+            entry.reviewHash = row[3].toULongLong(&entry.needsReview, 16);
+        }
+        m_entries[row[0]].insert(row[1], entry);
+    }
+    return true;
+}
+
+bool TranslationManifest::save(const QString &filePath, QString *errorMessage) const
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+
+    CsvWriter writer(&file);
+    writer.writeRow(QStringList() << "key" << "lang" << "hash" << "review");
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        for (auto lang = it.value().constBegin(); lang != it.value().constEnd(); ++lang) {
+            const Entry &entry = lang.value();
+            writer.writeRow(QStringList() << it.key() << lang.key() << QString::number(entry.sourceHash, 16)
+                            << (entry.needsReview ? QString::number(entry.reviewHash, 16) : QString()));
+        }
+    }
+
+    if (!writer.flush()) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool TranslationManifest::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+void TranslationManifest::record(const QString &key, const QString &lang, quint64 hash)
+{
+    if (!key.isEmpty()) {
+        Entry entry;
+        entry.sourceHash = hash;
+        m_entries[key].insert(lang, entry);
+    }
+}
+
+void TranslationManifest::recordForReview(const QString &key, const QString &lang, quint64 hash, quint64 translationHash)
+{
+    if (!key.isEmpty()) {
+        Entry entry;
+        entry.sourceHash = hash;
+        entry.reviewHash = translationHash;
+        entry.needsReview = true;
+        m_entries[key].insert(lang, entry);
+    }
+}
+
+QHash<QString, QBitArray> TranslationManifest::upToDateRows(const CsvTable &table, int sourceColumn,
+                                                            const QStringList &languages, int *staleCount,
+                                                            int *reviewCount)
+{
+    *staleCount = 0;
+    *reviewCount = 0;
+    QHash<QString, QBitArray> result = table.translatedRows(languages);
+    if (result.isEmpty()) {
+        return result;
+    }
+
+    for (int row = 0; row < table.rowCount(); ++row) {
+        // 没有键的行无法跟踪，保持按是否为空跳过
+        const QString key = table.cell(row, kKeyColumn);
+        if (key.isEmpty()) {
+            continue;
+        }
+
+        quint64 hash = 0;
+        QHash<QString, Entry> *langEntries = nullptr;
+        for (auto it = result.begin(); it != result.end(); ++it) {
+            if (!it.value().testBit(row)) {
+                continue;
+            }
+            if (!langEntries) {
+                hash = sourceHash(table.cell(row, sourceColumn));
+                langEntries = &m_entries[key];
+            }
+
+            auto recorded = langEntries->find(it.key());
+            if (recorded == langEntries->end()) {
+                Entry entry;
+                entry.sourceHash = hash;
+                langEntries->insert(it.key(), entry);
+            } else if (recorded->sourceHash != hash) {
+                it.value().clearBit(row);
+                (*staleCount)++;
+            } else if (recorded->needsReview) {
+                if (sourceHash(table.cell(row, table.columnIndex(it.key()))) == recorded->reviewHash) {
+                    it.value().clearBit(row);
+                    (*reviewCount)++;
+                } else {
+                    recorded->needsReview = false;
+                }
+            }
+        }
+    }
+    return result;
+}
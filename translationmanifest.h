@@ -0,0 +1,51 @@
+#ifndef TRANSLATIONMANIFEST_H
+#define TRANSLATIONMANIFEST_H
+
+#include <QBitArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include "csvtable.h"
+
+// 翻译清单：记录每个键(表格第一列)的每种语言译文是根据哪个版本的原文翻译的，
+// 保存为CSV旁的.manifest文件(CSV格式: key,lang,hash,review)
+// 按键而不是行号记录，行顺序变化不影响；原文修改后哈希不一致，再次翻译时只重新翻译这些行
+// 使用相似原文译文填写的单元格在review列记下所填译文的哈希，译文被人工修改之前不算已翻译
+class TranslationManifest
+{
+public:
+    static QString pathFor(const QString &csvPath);
+
+    // 原文去掉首尾空白后的64位FNV-1a哈希，与进程和平台无关
+    static quint64 sourceHash(const QString &text);
+
+    // 文件不存在时得到空清单并返回true
+    bool load(const QString &filePath, QString *errorMessage = nullptr);
+    bool save(const QString &filePath, QString *errorMessage = nullptr) const;
+
+    bool isEmpty() const;
+
+    // 记录key的lang译文由哈希为hash的原文翻译而来
+    void record(const QString &key, const QString &lang, quint64 hash);
+
+    // 记录key的lang译文是相似原文的译文，需要审核；translationHash是填入的译文的sourceHash()
+    void recordForReview(const QString &key, const QString &lang, quint64 hash, quint64 translationHash);
+
+    // 计算各语言中可以跳过的行：译文非空，且清单中没有记录或记录的原文哈希与当前原文一致
+    // 没有记录的已有译文(如手工翻译)视为最新并补记到清单；staleCount返回原文已修改的单元格数
+    // 待审核的相似译文仍是当初填入的内容时不跳过，reviewCount返回这类单元格数；译文已被修改则视为审核过
+    QHash<QString, QBitArray> upToDateRows(const CsvTable &table, int sourceColumn, const QStringList &languages,
+                                           int *staleCount, int *reviewCount);
+
+private:
+    struct Entry
+    {
+        quint64 sourceHash = 0;
+        quint64 reviewHash = 0;     // 待审核的相似译文的哈希
+        bool needsReview = false;
+    };
+
+    QHash<QString, QHash<QString, Entry>> m_entries; // key -> 语言 -> 记录
+};
+
+#endif // TRANSLATIONMANIFEST_H
@@ -0,0 +1,305 @@
+﻿#include "translationmemory.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QtEndian>
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <cstring>
+
+namespace {
+
+const char kMagic[4] = { 'S', 'G', 'T', 'M' };
+const quint32 kVersion = 1;
+const int kHeaderSize = 8;
+const int kRecordHeaderSize = 8;
+
+} // namespace
+
+TranslationMemory::TranslationMemory(const QString &filePath)
+    : m_filePath(filePath)
+{
+}
+
+TranslationMemory::~TranslationMemory()
+{
+    QMutexLocker locker(&m_mutex);
+    m_file.close();
+}
+
+QString TranslationMemory::defaultFilePath()
+{
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return dir + "/translation_memory.tm";
+}
+
+QString TranslationMemory::makeKey(const QString &text, const QString &from, const QString &to)
+{
+    return QString("%1-%2-%3").arg(from, to, text.trimmed());
+}
+
+QString TranslationMemory::filePath() const
+{
+    return m_filePath;
+}
+
+int TranslationMemory::size()
+{
+    QMutexLocker locker(&m_mutex);
+    ensureLoaded();
+    return m_index.size();
+}
+
+bool TranslationMemory::lookup(const QString &key, QString *value)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!ensureLoaded()) {
+        return false;
+    }
+
+    QHash<QByteArray, Entry>::const_iterator it = m_index.constFind(key.toUtf8());
+    if (it == m_index.constEnd()) {
+        return false;
+    }
+    return readValue(*it, value);
+}
+
+bool TranslationMemory::readValue(const Entry &entry, QString *value)
+{
+    if (!m_file.seek(entry.offset)) {
+        return false;
+    }
+    QByteArray data = m_file.read(entry.length);
+    if (data.size() != int(entry.length)) {
+        return false;
+    }
+
+    *value = QString::fromUtf8(data);
+    return true;
+}
+
+bool TranslationMemory::fuzzyLookup(const QString &text, const QString &from, const QString &to, double threshold,
+                                    FuzzyMatch *match)
+{
+    if (threshold <= 0.0) {
+        return false;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!ensureLoaded()) {
+            return false;
+        }
+    }
+    ensureFuzzyIndex();
+
+    // 查询只持有读锁，各工作线程可以同时查询
+    QString sourceText;
+    FuzzyIndex::Match found;
+    {
+        QReadLocker readLocker(&m_fuzzyLock);
+        QHash<QString, FuzzyIndex>::const_iterator index = m_fuzzyIndexes.constFind(from + '-' + to);
+        if (index == m_fuzzyIndexes.constEnd()) {
+            return false;
+        }
+        found = index->find(text.trimmed(), threshold);
+        if (found.id < 0) {
+            return false;
+        }
+        sourceText = index->text(found.id);
+    }
+
+    QString translation;
+    {
+        QMutexLocker locker(&m_mutex);
+        QHash<QByteArray, Entry>::const_iterator it = m_index.constFind(makeKey(sourceText, from, to).toUtf8());
+        if (it == m_index.constEnd() || !readValue(*it, &translation)) {
+            return false;
+        }
+    }
+
+    match->sourceText = sourceText;
+    match->translation = FuzzyIndex::transferNumbers(translation, sourceText, text.trimmed());
+    match->similarity = found.similarity;
+    return true;
+}
+
+void TranslationMemory::ensureFuzzyIndex()
+{
+    {
+        QReadLocker readLocker(&m_fuzzyLock);
+        if (m_fuzzyIndexed) {
+            return;
+        }
+    }
+
+    // 其他线程的相似查询等待索引建好，精确查询和写入只在复制键和最后交换时短暂加锁
+    QMutexLocker buildLocker(&m_fuzzyBuildMutex);
+    QList<QByteArray> keys;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_fuzzyIndexed) {
+            return;
+        }
+        keys = m_index.keys();
+        m_fuzzyBuilding = true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QHash<QString, FuzzyIndex> indexes;
+    for (const QByteArray &key : keys) {
+        addToFuzzyIndex(&indexes, key);
+    }
+
+    qint64 memoryBytes = 0;
+    {
+        QMutexLocker locker(&m_mutex);
+        QWriteLocker writeLocker(&m_fuzzyLock);
+        for (const QByteArray &key : m_fuzzyPending) {
+            addToFuzzyIndex(&indexes, key);
+        }
+        m_fuzzyPending.clear();
+        m_fuzzyIndexes.swap(indexes);
+        m_fuzzyBuilding = false;
+        m_fuzzyIndexed = true;
+        for (const FuzzyIndex &index : m_fuzzyIndexes) {
+            memoryBytes += index.memoryBytes();
+        }
+    }
+    qInfo() << u8"翻译记忆库相似索引已建立:" << keys.size() << u8"条，用时" << timer.elapsed() << u8"毫秒，约占内存"
+            << memoryBytes / (1024 * 1024) << "MB";
+}
+
+void TranslationMemory::addToFuzzyIndex(QHash<QString, FuzzyIndex> *indexes, const QByteArray &key)
+{
+    // 键的格式为"from-to-原文"，语言代码中不含'-'
+    const QString text = QString::fromUtf8(key);
+    const int first = text.indexOf('-');
+    const int second = first < 0 ? -1 : text.indexOf('-', first + 1);
+    if (second < 0) {
+        return;
+    }
+    (*indexes)[text.left(second)].add(text.mid(second + 1));
+}
+
+void TranslationMemory::insert(const QString &key, const QString &value)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!ensureLoaded()) {
+        return;
+    }
+
+    QByteArray keyData = key.toUtf8();
+    QByteArray valueData = value.toUtf8();
+
+    QByteArray record;
+    record.resize(kRecordHeaderSize);
+    qToLittleEndian<quint32>(quint32(keyData.size()), reinterpret_cast<uchar *>(record.data()));
+    qToLittleEndian<quint32>(quint32(valueData.size()), reinterpret_cast<uchar *>(record.data()) + 4);
+    record.append(keyData);
+    record.append(valueData);
+
+    qint64 recordOffset = m_file.size();
+    if (!m_file.seek(recordOffset) || m_file.write(record) != record.size()) {
+        qWarning() << u8"写入翻译记忆库失败:" << m_file.errorString();
+        return;
+    }
+
+    Entry entry;
+    entry.offset = recordOffset + kRecordHeaderSize + keyData.size();
+    entry.length = quint32(valueData.size());
+    // 同一个键再次写入时索引中已有原文；正在建立索引时先记下，建好后补上
+    if (!m_index.contains(keyData)) {
+        if (m_fuzzyIndexed) {
+            QWriteLocker writeLocker(&m_fuzzyLock);
+            addToFuzzyIndex(&m_fuzzyIndexes, keyData);
+        } else if (m_fuzzyBuilding) {
+            m_fuzzyPending.append(keyData);
+        }
+    }
+    m_index.insert(keyData, entry);
+}
+
+bool TranslationMemory::ensureLoaded()
+{
+    if (m_loaded) {
+        return true;
+    }
+    if (m_failed) {
+        return false;
+    }
+
+    m_loaded = loadIndex();
+    m_failed = !m_loaded;
+    return m_loaded;
+}
+
+bool TranslationMemory::loadIndex()
+{
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+
+    // 不使用缓冲，读写都直接落到文件上，避免读写交替时缓冲区不一致
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        qWarning() << u8"无法打开翻译记忆库:" << m_filePath << m_file.errorString();
+        return false;
+    }
+
+    if (m_file.size() < kHeaderSize) {
+        // 新文件（或连文件头都没写完的文件）直接重建
+        QByteArray header(kMagic, 4);
+        header.resize(kHeaderSize);
+        qToLittleEndian<quint32>(kVersion, reinterpret_cast<uchar *>(header.data()) + 4);
+        m_file.resize(0);
+        m_file.seek(0);
+        if (m_file.write(header) != header.size()) {
+            qWarning() << u8"无法初始化翻译记忆库:" << m_file.errorString();
+            m_file.close();
+            return false;
+        }
+        return true;
+    }
+
+    qint64 fileSize = m_file.size();
+    uchar *data = m_file.map(0, fileSize);
+    if (!data) {
+        qWarning() << u8"无法读取翻译记忆库:" << m_file.errorString();
+        m_file.close();
+        return false;
+    }
+
+    if (memcmp(data, kMagic, 4) != 0 || qFromLittleEndian<quint32>(data + 4) != kVersion) {
+        qWarning() << u8"翻译记忆库格式不兼容:" << m_filePath;
+        m_file.unmap(data);
+        m_file.close();
+        return false;
+    }
+
+    qint64 offset = kHeaderSize;
+    while (offset + kRecordHeaderSize <= fileSize) {
+        quint32 keyLength = qFromLittleEndian<quint32>(data + offset);
+        quint32 valueLength = qFromLittleEndian<quint32>(data + offset + 4);
+        qint64 recordEnd = offset + kRecordHeaderSize + keyLength + valueLength;
+        if (recordEnd > fileSize) {
+            break;
+        }
+
+        QByteArray key(reinterpret_cast<const char *>(data + offset + kRecordHeaderSize), int(keyLength));
+        Entry entry;
+        entry.offset = offset + kRecordHeaderSize + keyLength;
+        entry.length = valueLength;
+        m_index.insert(key, entry);
+        offset = recordEnd;
+    }
+    m_file.unmap(data);
+
+    // 上次异常退出时可能留下写了一半的记录，截断到最后一条完整记录
+    if (offset < fileSize) {
+        qWarning() << u8"翻译记忆库末尾存在不完整记录，已截断:" << (fileSize - offset) << u8"字节";
+        m_file.resize(offset);
+    }
+
+    return true;
+}
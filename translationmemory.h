@@ -0,0 +1,72 @@
+#ifndef TRANSLATIONMEMORY_H
+#define TRANSLATIONMEMORY_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QReadWriteLock>
+#include "fuzzyindex.h"
+
+// 持久化翻译记忆库：追加写入的记录文件 + 内存索引
+// 文件格式: "SGTM" + quint32版本号，之后每条记录为
+// quint32键长度 + quint32值长度 + 键(UTF-8) + 值(UTF-8)，同一个键以最后一条为准
+// 首次查询或写入时才读取文件建立索引，可被多个线程共享
+class TranslationMemory
+{
+public:
+    // 相似原文的查询结果
+    struct FuzzyMatch
+    {
+        QString sourceText;   // 记忆库中的原文
+        QString translation;  // 该原文的译文，数字已按查询文本替换
+        double similarity = 0.0;
+    };
+
+    explicit TranslationMemory(const QString &filePath = defaultFilePath());
+    ~TranslationMemory();
+
+    static QString defaultFilePath();
+    static QString makeKey(const QString &text, const QString &from, const QString &to);
+
+    QString filePath() const;
+    int size();
+    bool lookup(const QString &key, QString *value);
+    void insert(const QString &key, const QString &value);
+
+    // 查找同一语言对中与text相似度不低于threshold(0~1)的原文，返回最相似的一条
+    // 首次调用时为已有记录建立索引，建立和查询索引时不阻塞精确查询和写入
+    bool fuzzyLookup(const QString &text, const QString &from, const QString &to, double threshold, FuzzyMatch *match);
+
+private:
+    struct Entry
+    {
+        qint64 offset;
+        quint32 length;
+    };
+
+    bool ensureLoaded();
+    bool loadIndex();
+    bool readValue(const Entry &entry, QString *value);
+    void ensureFuzzyIndex();
+    static void addToFuzzyIndex(QHash<QString, FuzzyIndex> *indexes, const QByteArray &key);
+
+    QMutex m_mutex; // 保护文件、m_index以及索引的建立状态
+    QString m_filePath;
+    QFile m_file;
+    bool m_loaded = false;
+    bool m_failed = false;
+    QHash<QByteArray, Entry> m_index;
+
+    // 相似索引由m_fuzzyLock单独保护，多个线程可同时查询；加锁顺序总是先m_mutex后m_fuzzyLock
+    QMutex m_fuzzyBuildMutex;                  // 同一时间只有一个线程建立索引
+    QReadWriteLock m_fuzzyLock;
+    bool m_fuzzyIndexed = false;               // 持有m_mutex和m_fuzzyLock写锁时修改，持有任一个即可读取
+    bool m_fuzzyBuilding = false;              // 正在建立索引，期间新写入的键记在m_fuzzyPending
+    QList<QByteArray> m_fuzzyPending;
+    QHash<QString, FuzzyIndex> m_fuzzyIndexes; // "from-to" -> 该语言对的原文索引
+};
+
+#endif // TRANSLATIONMEMORY_H
@@ -0,0 +1,595 @@
+﻿#include "translationscheduler.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include "asynclogger.h"
+#include "csvio.h"
+#include "metricsregistry.h"
+#include "textnormalizer.h"
+
+namespace {
+
+// 每个工作单元包含的唯一文本数，单元越小负载越均衡，越大合并请求越充分
+const int kWorkUnitSize = 256;
+
+// 自动决定线程数时的上限，翻译主要等待网络，线程多了没有意义
+const int kMaxAutoWorkers = 8;
+
+} // namespace
+
+TranslationScheduler::TranslationScheduler(QObject *parent) : QObject(parent),
+    m_flushTimer(new QTimer(this)),
+    m_runElapsedMetric(MetricsRegistry::instance()->gauge(kMetricRunElapsed)),
+    m_cellsPerSecondMetric(MetricsRegistry::instance()->gauge(kMetricCellsPerSecond))
+{
+    // 各线程的结果在这里再汇总一次，界面每100毫秒只更新一次
+    qRegisterMetaType<TranslationProgress>("TranslationProgress");
+    m_flushTimer->setInterval(100);
+    connect(m_flushTimer, &QTimer::timeout, this, &TranslationScheduler::flushProgress);
+}
+
+TranslationScheduler::~TranslationScheduler()
+{
+    stopWorkers();
+}
+
+void TranslationScheduler::setTranslationData(const QStringList &sourceTexts, const QString &fromLang, const QStringList &targetLangs, bool forceRetranslate)
+{
+    m_sourceTexts = sourceTexts;
+    m_fromLang = fromLang;
+    m_targetLangs = targetLangs;
+    m_forceRetranslate = forceRetranslate;
+}
+
+void TranslationScheduler::setTranslatedRows(const QHash<QString, QBitArray> &translatedRows)
+{
+    m_translatedRows = translatedRows;
+}
+
+void TranslationScheduler::addBackend(const QSharedPointer<TranslationBackend> &backend, const QSharedPointer<RateLimiter> &rateLimiter)
+{
+    if (!backend) {
+        return;
+    }
+
+    BackendConfig config;
+    config.backend = backend;
+    config.rateLimiter = rateLimiter ? rateLimiter : QSharedPointer<RateLimiter>(new RateLimiter());
+    m_backends.append(config);
+}
+
+void TranslationScheduler::setTranslationMemory(const QSharedPointer<TranslationMemory> &translationMemory)
+{
+    m_translationMemory = translationMemory;
+}
+
+void TranslationScheduler::setMaxConcurrent(int maxConcurrent)
+{
+    m_maxConcurrent = qMax(1, maxConcurrent);
+}
+
+void TranslationScheduler::setMaxBatchBytes(int maxBatchBytes)
+{
+    m_maxBatchBytes = maxBatchBytes;
+}
+
+void TranslationScheduler::setWorkerCount(int workerCount)
+{
+    m_workerCount = qMax(0, workerCount);
+}
+
+void TranslationScheduler::setRetryPolicy(const RetryPolicy &retryPolicy)
+{
+    m_retryPolicy = retryPolicy;
+}
+
+void TranslationScheduler::setFuzzyThreshold(double threshold)
+{
+    m_fuzzyThreshold = threshold;
+}
+
+void TranslationScheduler::setMetricsPath(const QString &basePath)
+{
+    m_metricsPath = basePath;
+}
+
+void TranslationScheduler::stopTranslation()
+{
+    // 结果和清理在所有线程确认取消后的onWorkerStopped中完成
+    if (!m_done && !m_workers.isEmpty()) {
+        m_done = true;
+        m_stopRequested = true;
+    }
+    requestStop();
+}
+
+void TranslationScheduler::requestStop()
+{
+    if (m_workQueue) {
+        m_workQueue->clear();
+    }
+    if (m_cancellation && !m_cancellation->isCancelled()) {
+        m_stopElapsed.start();
+        m_cancellation->cancel();
+    }
+}
+
+void TranslationScheduler::startTranslation()
+{
+    stopWorkers();
+    m_done = false;
+    m_stopRequested = false;
+    m_pendingError.clear();
+    m_finishedWorkers = 0;
+    m_stoppedWorkers = 0;
+    m_runId++;
+    m_cancellation.reset(new CancellationToken());
+    MetricsRegistry::instance()->reset();
+    m_resultBuffer.clear();
+    m_timingBuffer.clear();
+    m_ttfbSamples.clear();
+    m_tlsHandshakes = 0;
+    m_tlsTotalMs = 0;
+    m_http2Requests = 0;
+    m_failureBuffer.clear();
+    m_failureCount = 0;
+    m_reviewBuffer.clear();
+    m_reviewCount = 0;
+
+    if (m_backends.isEmpty()) {
+        m_done = true;
+        emit translationError(u8"没有可用的翻译账号");
+        return;
+    }
+
+    int workerCount = m_workerCount;
+    if (workerCount <= 0) {
+        workerCount = qBound(1, m_targetLangs.size(), kMaxAutoWorkers);
+    }
+    m_workQueue.reset(new TranslationWorkQueue(workerCount));
+
+    int totalTexts = m_sourceTexts.size();
+    m_totalTranslations = totalTexts * m_targetLangs.size();
+    int unitCount = planWorkUnits();
+
+    // 每个账号的限速器和并发窗口由所有线程共享，窗口从1开始按响应情况调整
+    for (BackendConfig &config : m_backends) {
+        config.concurrency.reset(new ConcurrencyController(m_maxConcurrent));
+        config.lastWindow = config.concurrency->window();
+    }
+
+    emit logMessage(QString(u8"开始翻译，共%1个文本，%2种目标语言，总计%3个翻译任务，%4个工作线程，%5个工作单元，%6个翻译账号，每个账号最大并发请求数%7(自适应)")
+                   .arg(totalTexts).arg(m_targetLangs.size()).arg(m_totalTranslations).arg(workerCount)
+                   .arg(unitCount).arg(m_backends.size()).arg(m_maxConcurrent));
+    for (const BackendConfig &config : m_backends) {
+        emit logMessage(QString(u8"翻译账号: %1，限速%2次/秒(突发%3)")
+                       .arg(config.backend->name()).arg(config.rateLimiter->tokensPerSecond()).arg(config.rateLimiter->burst()));
+    }
+    if (m_translationMemory) {
+        emit logMessage(QString(u8"翻译记忆库: %1 (%2条)")
+                       .arg(m_translationMemory->filePath()).arg(m_translationMemory->size()));
+    }
+
+    // 会话线程在多次翻译之间保留，已预热或用过的连接可以直接复用
+    NetworkSessionPool *pool = NetworkSessionPool::instance();
+    QList<QUrl> endpoints;
+    for (const BackendConfig &config : m_backends) {
+        endpoints.append(config.backend->endpoint());
+    }
+    pool->session(workerCount - 1);
+    pool->warmUp(endpoints);
+
+    m_workerProgress.fill(TranslationProgress(), workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        NetworkSession *session = pool->session(i);
+        TranslationWorker *worker = new TranslationWorker();
+        worker->moveToThread(session->thread());
+        worker->setNetworkSession(session);
+
+        worker->setWorkQueue(m_workQueue, i);
+        worker->setFromLang(m_fromLang);
+        for (const BackendConfig &config : m_backends) {
+            worker->addBackend(config.backend, config.rateLimiter, config.concurrency);
+        }
+        worker->setTranslationMemory(m_translationMemory);
+        worker->setMaxBatchBytes(m_maxBatchBytes);
+        worker->setRetryPolicy(m_retryPolicy);
+        worker->setFuzzyThreshold(m_fuzzyThreshold);
+        worker->setCancellationToken(m_cancellation);
+
+        // 工作对象删除前发出的信号可能还在排队，只处理本次翻译的
+        const int runId = m_runId;
+        connect(worker, &TranslationWorker::progressUpdated, this, [this, i, runId](const TranslationProgress &progress) {
+            if (runId == m_runId) {
+                onWorkerProgress(i, progress);
+            }
+        });
+        connect(worker, &TranslationWorker::translationFinished, this, [this, runId]() {
+            if (runId == m_runId) {
+                onWorkerFinished();
+            }
+        });
+        connect(worker, &TranslationWorker::translationError, this, [this, runId](const QString &error) {
+            if (runId == m_runId) {
+                onWorkerError(error);
+            }
+        });
+        connect(worker, &TranslationWorker::translationStopped, this, [this, runId]() {
+            if (runId == m_runId) {
+                onWorkerStopped();
+            }
+        });
+        connect(worker, &TranslationWorker::logMessage, this, &TranslationScheduler::logMessage);
+
+        m_workers.append(worker);
+    }
+
+    m_elapsed.start();
+    m_flushTimer->start();
+    for (TranslationWorker *worker : m_workers) {
+        QMetaObject::invokeMethod(worker, "startTranslation", Qt::QueuedConnection);
+    }
+}
+
+int TranslationScheduler::planWorkUnits()
+{
+    // 空文本和已翻译的内容直接完成，其余单元格按(源语言,目标语言,文本)去重，
+    // 每条唯一文本只请求一次，结果再分发给所有相同文本的行
+    m_skippedTranslations = 0;
+    int cellsToTranslate = 0;
+    int uniqueTexts = 0;
+    int unitCount = 0;
+
+    // 占位符和标签替换成编号后再去重，只有占位符名称不同的文本共用一次请求
+    QStringList maskedTexts;
+    maskedTexts.reserve(m_sourceTexts.size());
+    m_placeholders.clear();
+    m_placeholders.resize(m_sourceTexts.size());
+    int maskedRows = 0;
+    int emptyCells = 0;
+    int translatedCells = 0;
+    int noTextCells = 0;
+    for (int i = 0; i < m_sourceTexts.size(); ++i) {
+        TextNormalizer::MaskedText masked = TextNormalizer::mask(m_sourceTexts[i]);
+        maskedTexts.append(masked.text);
+        if (!masked.placeholders.isEmpty()) {
+            m_placeholders[i] = masked.placeholders;
+            maskedRows++;
+        }
+    }
+
+    for (int langIndex = 0; langIndex < m_targetLangs.size(); ++langIndex) {
+        const QString &targetLang = m_targetLangs[langIndex];
+        const QBitArray translatedRows = m_translatedRows.value(targetLang);
+        QVector<TranslationTask> tasks;
+        QHash<QString, int> uniqueTasks;
+        for (int i = 0; i < m_sourceTexts.size(); ++i) {
+            const QString &sourceText = maskedTexts[i];
+            if (sourceText.isEmpty()) {
+                m_skippedTranslations++;
+                emptyCells++;
+                continue;
+            }
+
+            // 检查是否需要跳过已翻译的内容
+            if (!m_forceRetranslate && i < translatedRows.size() && translatedRows.testBit(i)) {
+                // 已经翻译过且不为空，跳过翻译，表格中已有内容无需回传
+                m_skippedTranslations++;
+                translatedCells++;
+                continue;
+            }
+
+            // 只有占位符、数字和符号的文本不需要翻译，原文直接作为译文
+            if (!TextNormalizer::needsTranslation(sourceText)) {
+                TranslationResult result;
+                result.row = i;
+                result.targetLang = targetLang;
+                result.text = sourceText;
+                TextNormalizer::restore(&result.text, m_placeholders[i]);
+                m_resultBuffer.append(result);
+                m_skippedTranslations++;
+                noTextCells++;
+                continue;
+            }
+
+            cellsToTranslate++;
+            QHash<QString, int>::const_iterator it = uniqueTasks.constFind(sourceText);
+            if (it != uniqueTasks.constEnd()) {
+                tasks[it.value()].rows.append(i);
+                continue;
+            }
+
+            TranslationTask task;
+            task.rows.append(i);
+            task.text = sourceText;
+            task.targetLang = targetLang;
+            uniqueTasks.insert(sourceText, tasks.size());
+            tasks.append(task);
+        }
+        uniqueTexts += tasks.size();
+
+        // 按行顺序切成工作单元，同一语言的单元先分给同一个线程
+        for (int first = 0; first < tasks.size(); first += kWorkUnitSize) {
+            TranslationWorkUnit unit;
+            unit.targetLang = targetLang;
+            unit.tasks = tasks.mid(first, kWorkUnitSize);
+            m_workQueue->push(langIndex, unit);
+            unitCount++;
+        }
+    }
+
+    emit logMessage(QString(u8"去重统计: %1个待翻译单元格合并为%2条唯一文本，节省%3次API调用")
+                   .arg(cellsToTranslate).arg(uniqueTexts).arg(cellsToTranslate - uniqueTexts));
+    MetricsRegistry *metrics = MetricsRegistry::instance();
+    metrics->counter(kMetricCellsSkipped, "reason", "empty")->add(emptyCells);
+    metrics->counter(kMetricCellsSkipped, "reason", "translated")->add(translatedCells);
+    metrics->counter(kMetricCellsSkipped, "reason", "no_text")->add(noTextCells);
+    metrics->counter(kMetricCellsDeduplicated)->add(cellsToTranslate - uniqueTexts);
+    if (maskedRows > 0) {
+        emit logMessage(QString(u8"%1行含占位符或标签，已替换为编号后再翻译").arg(maskedRows));
+    }
+    return unitCount;
+}
+
+void TranslationScheduler::onWorkerProgress(int workerIndex, const TranslationProgress &progress)
+{
+    // 译文按各行自己的占位符还原，编号丢失的单元格记为失败，不写入残缺的译文
+    m_resultBuffer.reserve(m_resultBuffer.size() + progress.results.size());
+    for (TranslationResult result : progress.results) {
+        if (!TextNormalizer::restore(&result.text, m_placeholders.value(result.row))) {
+            TranslationFailure failure;
+            failure.row = result.row;
+            failure.targetLang = result.targetLang;
+            failure.sourceText = m_sourceTexts.value(result.row);
+            failure.reason = QString(u8"译文中的占位符丢失: %1").arg(result.text.left(50));
+            m_failureBuffer.append(failure);
+            m_failureCount++;
+            continue;
+        }
+        m_resultBuffer.append(result);
+    }
+    m_timingBuffer += progress.requestTimings;
+    for (const RequestTiming &timing : progress.requestTimings) {
+        if (timing.ttfbMs >= 0) {
+            m_ttfbSamples.append(timing.ttfbMs);
+        }
+        if (timing.tlsMs >= 0) {
+            m_tlsHandshakes++;
+            m_tlsTotalMs += timing.tlsMs;
+        }
+        if (timing.http2) {
+            m_http2Requests++;
+        }
+    }
+    for (TranslationFailure failure : progress.failures) {
+        failure.sourceText = m_sourceTexts.value(failure.row);
+        m_failureBuffer.append(failure);
+    }
+    m_failureCount += progress.failures.size();
+    for (TranslationReview review : progress.reviews) {
+        review.sourceText = m_sourceTexts.value(review.row);
+        m_reviewBuffer.append(review);
+    }
+    m_reviewCount += progress.reviews.size();
+
+    TranslationProgress &counters = m_workerProgress[workerIndex];
+    counters.completed = progress.completed;
+    counters.requestCount = progress.requestCount;
+    counters.cacheHits = progress.cacheHits;
+    counters.requestedTexts = progress.requestedTexts;
+    counters.retryCount = progress.retryCount;
+}
+
+void TranslationScheduler::flushProgress()
+{
+    TranslationProgress progress;
+    progress.results.swap(m_resultBuffer);
+    progress.requestTimings.swap(m_timingBuffer);
+    progress.failures.swap(m_failureBuffer);
+    progress.reviews.swap(m_reviewBuffer);
+    progress.completed = m_skippedTranslations;
+    progress.total = m_totalTranslations;
+    for (const TranslationProgress &counters : m_workerProgress) {
+        progress.completed += counters.completed;
+        progress.requestCount += counters.requestCount;
+        progress.cacheHits += counters.cacheHits;
+        progress.requestedTexts += counters.requestedTexts;
+        progress.retryCount += counters.retryCount;
+    }
+    for (BackendConfig &config : m_backends) {
+        int window = config.concurrency->window();
+        if (window < config.lastWindow) {
+            emit logMessage(QString(u8"%1: 请求受限或超时，并发窗口从%2降到%3")
+                           .arg(config.backend->name()).arg(config.lastWindow).arg(window));
+        }
+        config.lastWindow = window;
+        progress.concurrencyWindow += window;
+    }
+    progress.elapsedMs = m_elapsed.elapsed();
+    m_runElapsedMetric->set(progress.elapsedMs);
+    m_cellsPerSecondMetric->set(progress.elapsedMs > 0 ? progress.completed * 1000.0 / progress.elapsedMs : 0.0);
+    emit progressUpdated(progress);
+}
+
+void TranslationScheduler::onWorkerFinished()
+{
+    m_finishedWorkers++;
+    if (m_done || m_finishedWorkers < m_workers.size()) {
+        return;
+    }
+
+    // 所有线程都已完成，它们最后一批进度在finished之前已送达
+    m_done = true;
+    m_flushTimer->stop();
+    flushProgress();
+
+    int requestCount = 0;
+    int retryCount = 0;
+    for (const TranslationProgress &counters : m_workerProgress) {
+        requestCount += counters.requestCount;
+        retryCount += counters.retryCount;
+    }
+    emit logMessage(QString(u8"本次共发送%1次翻译请求，%2个工作单元由空闲线程接手")
+                   .arg(requestCount).arg(m_workQueue->stolenCount()));
+    for (const BackendConfig &config : m_backends) {
+        emit logMessage(QString(u8"%1: 最终并发窗口%2/%3，降速%4次")
+                       .arg(config.backend->name()).arg(config.concurrency->window())
+                       .arg(config.concurrency->maxLimit()).arg(config.concurrency->decreaseCount()));
+    }
+    logNetworkStats();
+    if (retryCount > 0 || m_failureCount > 0) {
+        emit logMessage(QString(u8"失败重试%1次，%2个单元格多次重试后仍失败").arg(retryCount).arg(m_failureCount));
+    }
+    if (m_reviewCount > 0) {
+        emit logMessage(QString(u8"%1个单元格使用了翻译记忆库中相似原文的译文，需要审核").arg(m_reviewCount));
+    }
+    saveMetrics();
+    emit translationFinished();
+}
+
+void TranslationScheduler::onWorkerError(const QString &error)
+{
+    if (m_done) {
+        return;
+    }
+
+    // 任一线程失败即取消全部线程，等它们交回已完成的结果后再报告错误
+    m_done = true;
+    m_pendingError = error;
+    requestStop();
+}
+
+void TranslationScheduler::onWorkerStopped()
+{
+    m_stoppedWorkers++;
+    if (m_stoppedWorkers < m_workers.size()) {
+        return;
+    }
+
+    // 正常结束后的取消只需回收工作对象
+    if (m_pendingError.isEmpty() && !m_stopRequested) {
+        stopWorkers();
+        return;
+    }
+
+    // 各线程的最后一批结果在stopped之前已送达
+    m_flushTimer->stop();
+    flushProgress();
+    stopWorkers();
+    saveMetrics();
+    if (!m_pendingError.isEmpty()) {
+        const QString error = m_pendingError;
+        m_pendingError.clear();
+        emit translationError(error);
+    } else if (m_stopRequested) {
+        m_stopRequested = false;
+        emit logMessage(QString(u8"翻译已停止，取消用时%1毫秒").arg(m_stopElapsed.elapsed()));
+        emit translationStopped();
+    }
+}
+
+void TranslationScheduler::logNetworkStats()
+{
+    // 握手次数远小于请求数说明连接得到了复用；首字节时间包含排队、建立连接和服务器处理
+    if (m_ttfbSamples.isEmpty()) {
+        return;
+    }
+    QVector<qint64> samples = m_ttfbSamples;
+    std::sort(samples.begin(), samples.end());
+    qint64 p50 = samples[(samples.size() - 1) * 50 / 100];
+    qint64 p90 = samples[(samples.size() - 1) * 90 / 100];
+    emit logMessage(QString(u8"网络统计: %1次请求中新建TLS连接%2次(平均握手%3毫秒)，HTTP/2请求%4次，首字节时间p50 %5毫秒，p90 %6毫秒")
+                   .arg(samples.size()).arg(m_tlsHandshakes)
+                   .arg(m_tlsHandshakes > 0 ? m_tlsTotalMs / m_tlsHandshakes : 0)
+                   .arg(m_http2Requests).arg(p50).arg(p90));
+}
+
+void TranslationScheduler::saveMetrics()
+{
+    QString basePath = m_metricsPath;
+    if (basePath.isEmpty()) {
+        // 默认与日志文件放在一起，每次翻译一组文件
+        QString directory = AsyncLogger::instance()->directory();
+        if (directory.isEmpty() || !QDir().mkpath(directory)) {
+            return;
+        }
+        basePath = QDir(directory).filePath(QString("metrics_%1").arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss")));
+    }
+
+    QString errorMessage;
+    if (MetricsRegistry::instance()->save(basePath, &errorMessage)) {
+        emit logMessage(QString(u8"运行指标已保存到: %1.json / .prom").arg(basePath));
+    } else {
+        emit logMessage(QString(u8"保存运行指标失败: %1").arg(errorMessage));
+    }
+}
+
+bool TranslationScheduler::saveFailures(const QString &filePath, const QVector<TranslationFailure> &failures,
+                                        const QStringList &keys, QString *errorMessage)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+
+    // 行号按CSV文件中的行计，标题行为第1行
+    CsvWriter writer(&file);
+    writer.writeRow(QStringList() << "line" << "key" << "lang" << "source" << "error");
+    for (const TranslationFailure &failure : failures) {
+        writer.writeRow(QStringList() << QString::number(failure.row + 2) << keys.value(failure.row)
+                        << failure.targetLang << failure.sourceText << failure.reason);
+    }
+
+    if (!writer.flush()) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool TranslationScheduler::saveReviews(const QString &filePath, const QVector<TranslationReview> &reviews,
+                                       const QStringList &keys, QString *errorMessage)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+
+    CsvWriter writer(&file);
+    writer.writeRow(QStringList() << "line" << "key" << "lang" << "source" << "matched_source" << "similarity");
+    for (const TranslationReview &review : reviews) {
+        writer.writeRow(QStringList() << QString::number(review.row + 2) << keys.value(review.row) << review.targetLang
+                        << review.sourceText << review.matchedSource << QString::number(review.similarity, 'f', 2));
+    }
+
+    if (!writer.flush()) {
+        if (errorMessage) {
+            *errorMessage = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+void TranslationScheduler::stopWorkers()
+{
+    requestStop();
+    // 会话线程继续运行，工作对象必须在它所在的线程中删除
+    for (int i = 0; i < m_workers.size(); ++i) {
+        TranslationWorker *worker = m_workers[i];
+        QMetaObject::invokeMethod(NetworkSessionPool::instance()->session(i), [worker]() {
+            delete worker;
+        }, Qt::BlockingQueuedConnection);
+    }
+    m_workers.clear();
+    m_flushTimer->stop();
+}
@@ -0,0 +1,128 @@
+#ifndef TRANSLATIONSCHEDULER_H
+#define TRANSLATIONSCHEDULER_H
+
+#include <QObject>
+#include <QBitArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include "translationworker.h"
+
+// 翻译调度器：把(目标语言×行范围)的工作单元分给多个工作线程并行翻译
+// 工作线程及其网络连接来自NetworkSessionPool，翻译结束后保留给下一次翻译；
+// 各线程共享各账号的限速器和并发窗口，先做完的线程会窃取其他线程剩余的工作单元
+// 调度器运行在调用者的线程中，汇总各线程的结果后按与TranslationWorker相同的信号发出
+class TranslationScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TranslationScheduler(QObject *parent = nullptr);
+    ~TranslationScheduler();
+
+    void setTranslationData(const QStringList &sourceTexts, const QString &fromLang, const QStringList &targetLangs, bool forceRetranslate);
+    // 每种目标语言中已翻译的行，forceRetranslate为false时跳过这些行
+    void setTranslatedRows(const QHash<QString, QBitArray> &translatedRows);
+    void addBackend(const QSharedPointer<TranslationBackend> &backend, const QSharedPointer<RateLimiter> &rateLimiter);
+    void setTranslationMemory(const QSharedPointer<TranslationMemory> &translationMemory);
+    // 每个账号在所有线程中同时在途请求数的上限，实际并发由自适应窗口在此范围内调整
+    void setMaxConcurrent(int maxConcurrent);
+    void setMaxBatchBytes(int maxBatchBytes);
+    // 工作线程数，0表示按目标语言数自动决定
+    void setWorkerCount(int workerCount);
+    void setRetryPolicy(const RetryPolicy &retryPolicy);
+    // 翻译记忆库相似匹配的阈值(0~1)，0表示只使用完全相同的原文
+    void setFuzzyThreshold(double threshold);
+    // 翻译结束时指标写入basePath.json和basePath.prom，为空时写到日志目录
+    void setMetricsPath(const QString &basePath);
+    // 立即中止所有在途请求，各线程交回已完成的结果后发出translationStopped
+    void stopTranslation();
+
+    // 把多次重试仍失败的单元格写成CSV，keys为各行的键(表格第一列)
+    static bool saveFailures(const QString &filePath, const QVector<TranslationFailure> &failures,
+                             const QStringList &keys, QString *errorMessage = nullptr);
+    // 把使用相似原文译文的单元格写成CSV，供人工审核
+    static bool saveReviews(const QString &filePath, const QVector<TranslationReview> &reviews,
+                            const QStringList &keys, QString *errorMessage = nullptr);
+
+public slots:
+    void startTranslation();
+
+signals:
+    void progressUpdated(const TranslationProgress &progress);
+    void translationFinished();
+    void translationStopped();
+    void translationError(const QString &error);
+    void logMessage(const QString &message);
+
+private slots:
+    void flushProgress();
+
+private:
+    struct BackendConfig
+    {
+        QSharedPointer<TranslationBackend> backend;
+        QSharedPointer<RateLimiter> rateLimiter;
+        QSharedPointer<ConcurrencyController> concurrency;
+        int lastWindow = 0; // 上次汇报进度时的窗口，用于记录窗口缩小
+    };
+
+    int planWorkUnits();
+    void onWorkerProgress(int workerIndex, const TranslationProgress &progress);
+    void onWorkerFinished();
+    void onWorkerError(const QString &error);
+    void onWorkerStopped();
+    void requestStop();
+    void stopWorkers();
+    void logNetworkStats();
+    void saveMetrics();
+
+    QStringList m_sourceTexts;
+    QString m_fromLang;
+    QStringList m_targetLangs;
+    bool m_forceRetranslate = false;
+    QHash<QString, QBitArray> m_translatedRows;
+    QVector<QStringList> m_placeholders;  // 各行被替换为编号的占位符，翻译后按行还原
+    QVector<BackendConfig> m_backends;
+    QSharedPointer<TranslationMemory> m_translationMemory;
+    int m_maxConcurrent = 4;
+    int m_maxBatchBytes = kDefaultMaxBatchBytes;
+    int m_workerCount = 0;
+    RetryPolicy m_retryPolicy;
+    double m_fuzzyThreshold = 0.0;
+    QString m_metricsPath;
+
+    QSharedPointer<TranslationWorkQueue> m_workQueue;
+    QSharedPointer<CancellationToken> m_cancellation;
+    int m_runId = 0;  // 每次翻译递增，丢弃上一次翻译的工作对象迟到的信号
+    QVector<TranslationWorker *> m_workers;
+    QVector<TranslationProgress> m_workerProgress; // 各线程最近一次的累计计数，不含结果
+    int m_finishedWorkers = 0;
+    int m_stoppedWorkers = 0;
+    int m_skippedTranslations = 0;
+    int m_totalTranslations = 0;
+    bool m_done = false;
+    bool m_stopRequested = false;
+    QString m_pendingError;  // 取消完成后再发出的错误
+    QElapsedTimer m_stopElapsed;
+    QTimer *m_flushTimer;
+    QElapsedTimer m_elapsed;
+    MetricGauge *m_runElapsedMetric;    // 每次汇报进度时更新，构造时取得
+    MetricGauge *m_cellsPerSecondMetric;
+    QVector<TranslationResult> m_resultBuffer;
+    QVector<RequestTiming> m_timingBuffer;
+    QVector<qint64> m_ttfbSamples;  // 本次翻译所有请求的首字节时间，结束时统计分位数
+    int m_tlsHandshakes = 0;
+    qint64 m_tlsTotalMs = 0;
+    int m_http2Requests = 0;
+    QVector<TranslationFailure> m_failureBuffer;
+    int m_failureCount = 0;
+    QVector<TranslationReview> m_reviewBuffer;
+    int m_reviewCount = 0;
+};
+
+#endif // TRANSLATIONSCHEDULER_H
@@ -1,219 +1,563 @@
 ﻿#include "translationworker.h"
 
+namespace {
+
+// 并发窗口被其他线程占满时重新尝试的间隔
+const int kConcurrencyPollMs = 20;
+
+} // namespace
+
 TranslationWorker::TranslationWorker(QObject *parent) : QObject(parent),
-    m_shouldStop(false),
-    m_delayTime(100),
-    m_networkManager(new QNetworkAccessManager(this))
+    m_cancellation(new CancellationToken()),
+    m_dispatchTimer(new QTimer(this)),
+    m_flushTimer(new QTimer(this))
 {
+    m_dispatchTimer->setSingleShot(true);
+    connect(m_dispatchTimer, &QTimer::timeout, this, &TranslationWorker::dispatchPending);
+
+    // 结果每100毫秒汇总发送一次，界面开销与单元格数量无关
+    qRegisterMetaType<TranslationProgress>("TranslationProgress");
+    m_flushTimer->setInterval(100);
+    connect(m_flushTimer, &QTimer::timeout, this, &TranslationWorker::flushResults);
+
+    // 注册表中取得的指针在进程内一直有效，之后每个事件不再按名称查找和加锁
+    MetricsRegistry *metrics = MetricsRegistry::instance();
+    m_metrics.requestBytes = metrics->counter(kMetricRequestBytes);
+    m_metrics.responseBytes = metrics->counter(kMetricResponseBytes);
+    m_metrics.inFlight = metrics->gauge(kMetricInFlight);
+    m_metrics.requestDuration = metrics->histogram(kMetricRequestDuration);
+    m_metrics.requestTtfb = metrics->histogram(kMetricRequestTtfb);
+    m_metrics.parseDuration = metrics->histogram(kMetricParseDuration);
+    m_metrics.retries = metrics->counter(kMetricRetries);
+    m_metrics.cacheHits = metrics->counter(kMetricCacheHits, "source", "cache");
+    m_metrics.memoryHits = metrics->counter(kMetricCacheHits, "source", "memory");
+    m_metrics.fuzzyHits = metrics->counter(kMetricCacheHits, "source", "fuzzy");
+    m_metrics.cellsCompleted = metrics->counter(kMetricCellsCompleted);
+
     // 检查SSL支持状态
     if (!QSslSocket::supportsSsl()) {
         emit logMessage(u8"警告: OpenSSL不可用，HTTPS请求可能失败");
         emit logMessage(u8"请参考SSL_SETUP_GUIDE.md文档配置OpenSSL");
     }
 
-    // 配置SSL以解决TLS初始化问题
-    QSslConfiguration sslConfig = QSslConfiguration::defaultConfiguration();
-    sslConfig.setProtocol(QSsl::TlsV1_2OrLater);
-    sslConfig.setPeerVerifyMode(QSslSocket::VerifyNone);
-    QSslConfiguration::setDefaultConfiguration(sslConfig);
-    
     emit logMessage(QString(u8"TranslationWorker初始化完成，SSL支持: %1").arg(QSslSocket::supportsSsl() ? u8"是" : u8"否"));
 }
 
-void TranslationWorker::setConfig(const QString &appId, const QString &secretKey)
+TranslationWorker::~TranslationWorker()
+{
+    // 网络会话比工作对象活得久，未完成的请求要在这里取消
+    abortInFlight();
+}
+
+void TranslationWorker::setNetworkSession(NetworkSession *session)
+{
+    m_session = session;
+}
+
+void TranslationWorker::addBackend(const QSharedPointer<TranslationBackend> &backend, const QSharedPointer<RateLimiter> &rateLimiter,
+                                   const QSharedPointer<ConcurrencyController> &concurrency)
 {
-    m_appId = appId;
-    m_secretKey = secretKey;
+    if (!backend) {
+        return;
+    }
+
+    BackendSlot slot;
+    slot.backend = backend;
+    slot.rateLimiter = rateLimiter ? rateLimiter : QSharedPointer<RateLimiter>(new RateLimiter());
+    slot.concurrency = concurrency ? concurrency : QSharedPointer<ConcurrencyController>(new ConcurrencyController());
+    slot.requestsMetric = MetricsRegistry::instance()->counter(kMetricRequests, "backend", backend->name());
+    slot.billedCharactersMetric = MetricsRegistry::instance()->counter(kMetricBilledCharacters, "backend", backend->name());
+    m_backends.append(slot);
+}
+
+void TranslationWorker::setWorkQueue(const QSharedPointer<TranslationWorkQueue> &workQueue, int workerIndex)
+{
+    m_workQueue = workQueue;
+    m_workerIndex = workerIndex;
 }
 
-void TranslationWorker::setTranslationData(const QStringList &sourceTexts, const QString &fromLang, const QStringList &targetLangs, bool forceRetranslate)
+void TranslationWorker::setFromLang(const QString &fromLang)
 {
-    m_sourceTexts = sourceTexts;
     m_fromLang = fromLang;
-    m_targetLangs = targetLangs;
-    m_forceRetranslate = forceRetranslate;
 }
 
-void TranslationWorker::setExistingTranslations(const QHash<QString, QHash<int, QString>> &existingTranslations)
+void TranslationWorker::setRetryPolicy(const RetryPolicy &retryPolicy)
+{
+    m_retryPolicy = retryPolicy;
+}
+
+void TranslationWorker::setFuzzyThreshold(double threshold)
+{
+    m_fuzzyThreshold = threshold;
+}
+
+void TranslationWorker::setMaxBatchBytes(int maxBatchBytes)
 {
-    m_existingTranslations = existingTranslations;
+    m_maxBatchBytes = maxBatchBytes;
 }
 
-void TranslationWorker::setDelayTime(int delayMs)
+void TranslationWorker::setTranslationMemory(const QSharedPointer<TranslationMemory> &translationMemory)
 {
-    m_delayTime = delayMs;
+    m_translationMemory = translationMemory;
+}
+
+void TranslationWorker::setCancellationToken(const QSharedPointer<CancellationToken> &cancellation)
+{
+    if (!cancellation) {
+        return;
+    }
+
+    disconnect(m_cancellation.data(), &CancellationToken::cancelled, this, &TranslationWorker::onCancelled);
+    m_cancellation = cancellation;
+    // 标志可能在任意线程被设置，排队到本线程处理
+    connect(m_cancellation.data(), &CancellationToken::cancelled, this, &TranslationWorker::onCancelled, Qt::QueuedConnection);
 }
 
 void TranslationWorker::stopTranslation()
 {
-    QMutexLocker locker(&m_mutex);
-    m_shouldStop = true;
+    m_cancellation->cancel();
+}
+
+bool TranslationWorker::isStopped() const
+{
+    return m_cancellation->isCancelled();
+}
+
+void TranslationWorker::onCancelled()
+{
+    // 不等待服务器响应，直接中止所有在途请求，退避中的重试随定时器一起作废
+    m_dispatchTimer->stop();
+    abortInFlight();
+    m_pendingTasks.clear();
+    m_waitingRetries = 0;
+    if (!m_finished) {
+        m_finished = true;
+        m_flushTimer->stop();
+        emit logMessage(QString(u8"工作线程%1已取消，共发送%2次翻译请求").arg(m_workerIndex + 1).arg(m_requestCount));
+    }
+    flushResults();
+    emit translationStopped();
 }
 
 void TranslationWorker::startTranslation()
 {
-    m_shouldStop = false;
-    int totalTexts = m_sourceTexts.size();
-    int totalTranslations = totalTexts * m_targetLangs.size();
-    int currentIndex = 0;
-    
-    emit logMessage(QString(u8"开始翻译，共%1个文本，%2种目标语言，总计%3个翻译任务")
-                   .arg(totalTexts).arg(m_targetLangs.size()).arg(totalTranslations));
-    
-    for (const QString &targetLang : m_targetLangs) {
-        if (m_shouldStop) {
-            emit logMessage(u8"翻译已停止");
+    m_finished = false;
+    m_pendingTasks.clear();
+    m_completedTranslations = 0;
+    m_requestCount = 0;
+    m_cacheHits = 0;
+    m_requestedTexts = 0;
+    m_retryCount = 0;
+    m_waitingRetries = 0;
+    m_nextBackend = 0;
+    m_resultBuffer.clear();
+    m_timingBuffer.clear();
+    m_failureBuffer.clear();
+    m_reviewBuffer.clear();
+    m_elapsed.start();
+    m_flushTimer->start();
+
+    if (m_backends.isEmpty() || !m_workQueue || !m_session) {
+        m_finished = true;
+        m_flushTimer->stop();
+        emit translationError(u8"没有可用的翻译账号");
+        return;
+    }
+
+    for (BackendSlot &slot : m_backends) {
+        slot.inFlight = 0;
+        slot.requestCount = 0;
+    }
+
+    dispatchPending();
+}
+
+bool TranslationWorker::takeWorkUnit()
+{
+    TranslationWorkUnit unit;
+    bool stolen = false;
+    if (!m_workQueue || !m_workQueue->take(m_workerIndex, &unit, &stolen)) {
+        return false;
+    }
+
+    if (stolen) {
+        emit logMessage(QString(u8"工作线程%1已完成自己的任务，接手%2的%3条文本")
+                       .arg(m_workerIndex + 1).arg(unit.targetLang).arg(unit.tasks.size()));
+    }
+    for (const TranslationTask &task : unit.tasks) {
+        m_pendingTasks.enqueue(task);
+    }
+    return true;
+}
+
+void TranslationWorker::dispatchPending()
+{
+    if (isStopped()) {
+        m_pendingTasks.clear();
+        checkFinished();
+        return;
+    }
+
+    // 本线程的任务发完后再从共享队列取下一个工作单元
+    while (!m_pendingTasks.isEmpty() || takeWorkUnit()) {
+        if (isStopped()) {
+            m_pendingTasks.clear();
             break;
         }
-        
-        for (int i = 0; i < m_sourceTexts.size(); ++i) {
-            if (m_shouldStop) {
-                emit logMessage(u8"翻译已停止");
-                return;
-            }
-            
-            const QString &sourceText = m_sourceTexts[i];
-            if (sourceText.trimmed().isEmpty()) {
-                currentIndex++;
-                continue;
-            }
-            
-            // 检查是否需要跳过已翻译的内容
-            if (!m_forceRetranslate && m_existingTranslations.contains(targetLang)) {
-                const QHash<int, QString> &langTranslations = m_existingTranslations[targetLang];
-                if (langTranslations.contains(i) && !langTranslations[i].trimmed().isEmpty()) {
-                    // 已经翻译过且不为空，跳过翻译
-                    currentIndex++;
-                    emit progressUpdated(currentIndex, totalTranslations, sourceText, langTranslations[i], targetLang);
-                    continue;
-                }
+
+        // 缓存或翻译记忆库命中的任务不占用请求名额，也不需要等待
+        QString cachedText;
+        if (lookupCache(m_pendingTasks.head(), &cachedText)) {
+            completeTask(m_pendingTasks.dequeue(), cachedText);
+            continue;
+        }
+
+        // 所有账号都没有空闲名额或令牌时，等令牌产生或请求完成后再发
+        int waitMs = 0;
+        int backendIndex = acquireBackend(&waitMs);
+        if (backendIndex < 0) {
+            if (waitMs > 0 && !m_dispatchTimer->isActive()) {
+                m_dispatchTimer->start(waitMs);
             }
-            
-            QString translatedText = translateText(sourceText, m_fromLang, targetLang);
-            if (translatedText.isEmpty()) {
-                emit translationError(QString(u8"翻译失败: %1").arg(sourceText.left(50)));
-                return;
+            return;
+        }
+
+        sendRequest(backendIndex, takeBatch(m_backends[backendIndex].backend->maxBatchBytes()));
+    }
+
+    checkFinished();
+}
+
+int TranslationWorker::acquireBackend(int *waitMs)
+{
+    // 从上次使用的账号之后开始轮流查找，使负载均匀分布到各账号
+    *waitMs = 0;
+    for (int n = 0; n < m_backends.size(); ++n) {
+        int index = (m_nextBackend + n) % m_backends.size();
+        BackendSlot &slot = m_backends[index];
+
+        // 并发窗口由所有线程共享，名额可能被其他线程占用，本线程没有在途请求时也要定时再试
+        if (!slot.concurrency->tryAcquire()) {
+            if (*waitMs == 0 || kConcurrencyPollMs < *waitMs) {
+                *waitMs = kConcurrencyPollMs;
             }
-            
-            currentIndex++;
-            emit progressUpdated(currentIndex, totalTranslations, sourceText, translatedText, targetLang);
-            
-            // 添加延迟以避免API限制
-            QEventLoop loop;
-            QTimer::singleShot(m_delayTime, &loop, &QEventLoop::quit);
-            loop.exec();
+            continue;
+        }
+
+        // 每个网络请求消耗所属账号的一个令牌，账号被要求降速时所有线程都等到暂停结束
+        int wait = slot.rateLimiter->tryAcquire();
+        if (wait == 0) {
+            m_nextBackend = (index + 1) % m_backends.size();
+            return index;
+        }
+        slot.concurrency->release();
+        if (*waitMs == 0 || wait < *waitMs) {
+            *waitMs = wait;
         }
     }
-    
-    if (!m_shouldStop) {
-        emit translationFinished();
+    return -1;
+}
+
+QVector<TranslationTask> TranslationWorker::takeBatch(int maxBatchBytes)
+{
+    QVector<TranslationTask> batch;
+    batch.append(m_pendingTasks.dequeue());
+
+    // 含换行的文本本身就会被拆成多段，只能单独请求
+    const TranslationTask &first = batch.first();
+    maxBatchBytes = qMin(maxBatchBytes, m_maxBatchBytes);
+    if (maxBatchBytes <= 0 || first.single || first.text.contains('\n') || first.text.contains('\r')) {
+        return batch;
     }
+
+    // 把后续同一目标语言的短文本用换行拼接进同一个请求，直到达到字节上限
+    const QString targetLang = first.targetLang;
+    int batchBytes = first.text.trimmed().toUtf8().size();
+    while (!m_pendingTasks.isEmpty()) {
+        const TranslationTask &next = m_pendingTasks.head();
+        if (next.single || next.targetLang != targetLang || next.text.contains('\n') || next.text.contains('\r')) {
+            break;
+        }
+
+        QString cachedText;
+        if (lookupCache(next, &cachedText)) {
+            completeTask(m_pendingTasks.dequeue(), cachedText);
+            continue;
+        }
+
+        int segmentBytes = next.text.trimmed().toUtf8().size() + 1; // 加上换行分隔符
+        if (batchBytes + segmentBytes > maxBatchBytes) {
+            break;
+        }
+        batchBytes += segmentBytes;
+        batch.append(m_pendingTasks.dequeue());
+    }
+
+    return batch;
 }
 
-QString TranslationWorker::translateText(const QString &text, const QString &from, const QString &to)
+void TranslationWorker::sendRequest(int backendIndex, const QVector<TranslationTask> &batch)
 {
-    if (text.trimmed().isEmpty()) {
-        return text;
+    BackendSlot &slot = m_backends[backendIndex];
+
+    // 多条文本以换行分隔，翻译接口会按段返回结果
+    QString text;
+    if (batch.size() == 1) {
+        text = batch.first().text;
+    } else {
+        QStringList segments;
+        for (const TranslationTask &task : batch) {
+            segments.append(task.text.trimmed());
+        }
+        text = segments.join('\n');
     }
-    
-    // 检查SSL支持
-    if (!QSslSocket::supportsSsl()) {
+
+    QByteArray body;
+    QNetworkRequest request = slot.backend->buildRequest(text, m_fromLang, batch.first().targetLang, &body);
+
+    // 检查SSL支持，本地模拟服务器使用http时不需要
+    if (request.url().scheme() == "https" && !QSslSocket::supportsSsl()) {
         emit logMessage(u8"错误: OpenSSL不可用，无法进行HTTPS请求");
         emit logMessage(u8"请按照SSL_SETUP_GUIDE.md文档配置OpenSSL后重试");
-        return QString(); // 返回空字符串表示失败
-    }
-    
-    // 检查缓存
-    QString cacheKey = getCacheKey(text, from, to);
-    if (m_translationCache.contains(cacheKey)) {
-        return m_translationCache[cacheKey];
-    }
-    
-    // 构建请求参数
-    QString salt = QString::number(QDateTime::currentMSecsSinceEpoch());
-    QString sign = generateSign(text, salt);
-    
-    QUrl url("https://fanyi-api.baidu.com/api/trans/vip/translate");
-    QUrlQuery query;
-    query.addQueryItem("q", text);
-    query.addQueryItem("from", from);
-    query.addQueryItem("to", to);
-    query.addQueryItem("appid", m_appId);
-    query.addQueryItem("salt", salt);
-    query.addQueryItem("sign", sign);
-    
-    QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
-    
-    // 设置SSL配置以避免TLS错误
-    QSslConfiguration sslConfig = request.sslConfiguration();
-    sslConfig.setProtocol(QSsl::TlsV1_2OrLater);
-    sslConfig.setPeerVerifyMode(QSslSocket::VerifyNone);
-    request.setSslConfiguration(sslConfig);
-    
-    QNetworkReply *reply = m_networkManager->post(request, query.toString(QUrl::FullyEncoded).toUtf8());
-    
-    // 设置超时
-    QTimer timeoutTimer;
-    timeoutTimer.setSingleShot(true);
-    timeoutTimer.setInterval(30000); // 30秒超时
-    
-    QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    connect(&timeoutTimer, &QTimer::timeout, &loop, &QEventLoop::quit);
+        emit translationError(QString(u8"翻译失败: %1").arg(batch.first().text.left(50)));
+        slot.concurrency->release();
+        stopTranslation();
+        return;
+    }
+
+    QNetworkReply *reply = m_session->post(request, body);
+    m_requestCount++;
+    m_requestedTexts += batch.size();
+    slot.inFlight++;
+    slot.requestCount++;
+    slot.requestsMetric->add();
+    m_metrics.requestBytes->add(body.size());
+    m_metrics.inFlight->add(1);
+
+    InFlightRequest inFlight;
+    inFlight.backendIndex = backendIndex;
+    inFlight.characters = text.size();
+    inFlight.tasks = batch;
+    m_inFlight.insert(reply, inFlight);
+
+    // 设置超时，超时后中止请求，由finished统一处理
+    QTimer *timeoutTimer = new QTimer(reply);
+    timeoutTimer->setSingleShot(true);
+    connect(timeoutTimer, &QTimer::timeout, reply, [reply]() {
+        reply->setProperty("timedOut", true);
+        reply->abort();
+    });
+    timeoutTimer->start(30000); // 30秒超时
+
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        onReplyFinished(reply);
+    });
     connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::error),
-            [this, reply](QNetworkReply::NetworkError error) {
+            this, [this, reply](QNetworkReply::NetworkError error) {
                 emit logMessage(QString(u8"网络请求错误代码: %1, 错误信息: %2")
                                .arg(error).arg(reply->errorString()));
             });
-    
-    timeoutTimer.start();
-    loop.exec();
-    timeoutTimer.stop();
-    
-    QString result;
-    
+}
+
+void TranslationWorker::onReplyFinished(QNetworkReply *reply)
+{
+    reply->deleteLater();
+    if (!m_inFlight.contains(reply)) {
+        return;
+    }
+
+    const InFlightRequest inFlight = m_inFlight.take(reply);
+    const QVector<TranslationTask> &batch = inFlight.tasks;
+    BackendSlot &slot = m_backends[inFlight.backendIndex];
+    slot.inFlight--;
+    RequestTiming timing = m_session->timing(reply);
+    m_timingBuffer.append(timing);
+    m_metrics.inFlight->add(-1);
+    if (timing.totalMs >= 0) {
+        m_metrics.requestDuration->observe(timing.totalMs);
+    }
+    if (timing.ttfbMs >= 0) {
+        m_metrics.requestTtfb->observe(timing.ttfbMs);
+    }
+    QStringList sources;
+    QStringList results;
+    RetryAction action = RetryAction::Retry;
+    QString reason;
+
+    if (!parseReply(reply, slot.backend.data(), &sources, &results, &action, &reason)) {
+        // 频率受限和超时说明已超出服务器当前的承受能力，缩小并发窗口
+        slot.concurrency->onFailure(action == RetryAction::SlowDown || reply->property("timedOut").toBool());
+        if (isStopped()) {
+            m_pendingTasks.clear();
+            checkFinished();
+            return;
+        }
+        handleFailure(inFlight.backendIndex, batch, action, reason);
+        dispatchPending();
+        return;
+    }
+    slot.concurrency->onSuccess(timing.totalMs);
+    slot.billedCharactersMetric->add(inFlight.characters);
+
+    if (batch.size() == 1) {
+        // 单条文本含换行时会返回多段结果，按原样拼回
+        const TranslationTask &task = batch.first();
+        QString translatedText = results.join('\n');
+        storeCache(task, translatedText);
+        emit logMessage(QString(u8"翻译成功: %1 -> %2").arg(task.text.left(20), translatedText.left(20)));
+        completeTask(task, translatedText);
+    } else if (results.size() == batch.size()) {
+        for (int i = 0; i < batch.size(); ++i) {
+            const TranslationTask &task = batch[i];
+            storeCache(task, results[i]);
+            completeTask(task, results[i]);
+        }
+        emit logMessage(QString(u8"批量翻译成功: %1条文本合并为1次请求").arg(batch.size()));
+    } else {
+        // 段数对不上时按原文匹配，匹配不上的改为单独请求
+        QHash<QString, QString> resultBySource;
+        for (int i = 0; i < results.size() && i < sources.size(); ++i) {
+            resultBySource.insert(sources[i].trimmed(), results[i]);
+        }
+
+        QVector<TranslationTask> retryTasks;
+        for (const TranslationTask &task : batch) {
+            QString key = task.text.trimmed();
+            if (resultBySource.contains(key)) {
+                storeCache(task, resultBySource.value(key));
+                completeTask(task, resultBySource.value(key));
+            } else {
+                TranslationTask retryTask = task;
+                retryTask.single = true;
+                retryTasks.append(retryTask);
+            }
+        }
+        for (int i = retryTasks.size() - 1; i >= 0; --i) {
+            m_pendingTasks.prepend(retryTasks[i]);
+        }
+        emit logMessage(QString(u8"批量翻译结果段数不匹配(请求%1段，返回%2段)，%3条文本改为单独请求")
+                       .arg(batch.size()).arg(results.size()).arg(retryTasks.size()));
+    }
+
+    dispatchPending();
+}
+
+void TranslationWorker::handleFailure(int backendIndex, const QVector<TranslationTask> &batch, RetryAction action, const QString &reason)
+{
+    if (action == RetryAction::FailJob) {
+        // 账号或配置错误，继续发送只会得到同样的错误
+        flushResults();
+        emit translationError(QString(u8"翻译失败: %1").arg(reason));
+        stopTranslation();
+        abortInFlight();
+        m_pendingTasks.clear();
+        return;
+    }
+
+    if (action == RetryAction::FailCell && batch.size() > 1) {
+        // 合并请求中可能只有一条有问题，拆开单独请求找出它
+        for (int i = batch.size() - 1; i >= 0; --i) {
+            TranslationTask task = batch[i];
+            task.single = true;
+            m_pendingTasks.prepend(task);
+        }
+        emit logMessage(QString(u8"%1，%2条文本改为单独请求").arg(reason).arg(batch.size()));
+        return;
+    }
+
+    QVector<TranslationTask> retryTasks;
+    int maxAttempts = m_retryPolicy.maxAttempts(action);
+    int attempt = 0;
+    for (TranslationTask task : batch) {
+        task.attempts++;
+        if (action == RetryAction::FailCell || task.attempts >= maxAttempts) {
+            failTask(task, reason);
+            continue;
+        }
+        attempt = qMax(attempt, task.attempts);
+        retryTasks.append(task);
+    }
+    if (retryTasks.isEmpty()) {
+        return;
+    }
+
+    int delay = m_retryPolicy.backoffMs(attempt);
+    if (action == RetryAction::SlowDown) {
+        // 频率受限时暂停该账号，至少等到下一秒的配额；限流器由所有线程共享，暂停对所有线程生效
+        delay = qMax(delay, 1000);
+        m_backends[backendIndex].rateLimiter->pauseFor(delay);
+    }
+
+    m_retryCount++;
+    m_metrics.retries->add();
+    m_waitingRetries += retryTasks.size();
+    emit logMessage(QString(u8"%1，%2条文本%3毫秒后第%4次%5")
+                   .arg(reason).arg(retryTasks.size()).arg(delay).arg(attempt)
+                   .arg(RetryPolicy::actionName(action)));
+
+    QTimer::singleShot(delay, this, [this, retryTasks]() {
+        // 取消时onCancelled已清零等待计数
+        if (isStopped()) {
+            return;
+        }
+        m_waitingRetries -= retryTasks.size();
+        for (int i = retryTasks.size() - 1; i >= 0; --i) {
+            m_pendingTasks.prepend(retryTasks[i]);
+        }
+        dispatchPending();
+    });
+}
+
+void TranslationWorker::failTask(const TranslationTask &task, const QString &reason)
+{
+    // 记入失败列表，算作已完成，任务的其余部分照常进行
+    for (int row : task.rows) {
+        TranslationFailure failure;
+        failure.row = row;
+        failure.targetLang = task.targetLang;
+        failure.sourceText = task.text;
+        failure.reason = reason;
+        m_failureBuffer.append(failure);
+    }
+    m_completedTranslations += task.rows.size();
+    emit logMessage(QString(u8"翻译失败，已记入失败列表: %1 (%2)").arg(task.text.left(50), reason));
+}
+
+bool TranslationWorker::parseReply(QNetworkReply *reply, const TranslationBackend *backend, QStringList *sources, QStringList *results,
+                                   RetryAction *action, QString *reason)
+{
+    // 响应格式不对或为空时按临时错误重试
+    *action = RetryAction::Retry;
+
     // 检查是否超时
-    if (!timeoutTimer.isActive() && reply->isRunning()) {
-        reply->abort();
-        emit logMessage(u8"请求超时，已取消请求");
+    // 失败按接口的error_code或网络错误类型分别计数
+    if (reply->property("timedOut").toBool()) {
+        *reason = u8"请求超时，已取消请求";
+        errorMetric("timeout")->add();
     } else if (reply->error() == QNetworkReply::NoError) {
         QByteArray responseData = reply->readAll();
-        
+        m_metrics.responseBytes->add(responseData.size());
+
         if (responseData.isEmpty()) {
-            emit logMessage(u8"服务器返回空响应");
+            *reason = u8"服务器返回空响应";
+            errorMetric("empty")->add();
         } else {
-            QJsonParseError parseError;
-            QJsonDocument doc = QJsonDocument::fromJson(responseData, &parseError);
-            
-            if (parseError.error != QJsonParseError::NoError) {
-                emit logMessage(QString(u8"JSON解析错误: %1").arg(parseError.errorString()));
-            } else {
-                QJsonObject obj = doc.object();
-                
-                if (obj.contains("trans_result")) {
-                    QJsonArray transResult = obj["trans_result"].toArray();
-                    if (!transResult.isEmpty()) {
-                        QJsonObject firstResult = transResult[0].toObject();
-                        result = firstResult["dst"].toString();
-                        
-                        // 缓存结果
-                        m_translationCache[cacheKey] = result;
-                        emit logMessage(QString(u8"翻译成功: %1 -> %2")
-                                       .arg(text.left(20), result.left(20)));
-                    } else {
-                        emit logMessage(u8"翻译结果为空");
-                    }
-                } else if (obj.contains("error_code")) {
-                    QString errorCode = obj["error_code"].toString();
-                    QString errorMsg = obj["error_msg"].toString();
-                    emit logMessage(QString(u8"百度API错误: %1 - %2").arg(errorCode, errorMsg));
-                } else {
-                    emit logMessage(u8"未知的API响应格式");
+            QString errorCode;
+            QString errorMessage;
+            QElapsedTimer parseTimer;
+            parseTimer.start();
+            bool decoded = backend->decodeReply(responseData, sources, results, &errorCode, &errorMessage);
+            m_metrics.parseDuration->observe(parseTimer.nsecsElapsed() / 1000000.0);
+            if (!decoded) {
+                *reason = QString(u8"%1: %2").arg(backend->name(), errorMessage);
+                errorMetric(errorCode.isEmpty() ? QString("invalid_reply") : errorCode)->add();
+                if (!errorCode.isEmpty()) {
+                    *action = backend->classifyError(errorCode);
                 }
             }
         }
-    } else {
+    } else if (reply->error() != QNetworkReply::OperationCanceledError || !isStopped()) {
+        errorMetric(QString("network_%1").arg(int(reply->error())))->add();
         QString errorDetail;
         switch (reply->error()) {
         case QNetworkReply::ConnectionRefusedError:
@@ -259,21 +603,142 @@ QString TranslationWorker::translateText(const QString &text, const QString &fro
             errorDetail = QString(u8"未知错误(代码:%1)").arg(reply->error());
             break;
         }
-        emit logMessage(QString(u8"网络错误: %1 - %2").arg(errorDetail, reply->errorString()));
+        *reason = QString(u8"网络错误: %1 - %2").arg(errorDetail, reply->errorString());
+        *action = RetryPolicy::classifyNetworkError(reply->error());
     }
-    
-    reply->deleteLater();
-    return result;
+
+    return !results->isEmpty();
+}
+
+bool TranslationWorker::lookupCache(const TranslationTask &task, QString *translatedText)
+{
+    QString cacheKey = getCacheKey(task.text, m_fromLang, task.targetLang);
+    QHash<QString, QString>::const_iterator it = m_translationCache.constFind(cacheKey);
+    if (it != m_translationCache.constEnd()) {
+        *translatedText = it.value();
+        m_cacheHits++;
+        m_metrics.cacheHits->add();
+        return true;
+    }
+
+    // 本次运行没有翻译过的再查持久化的翻译记忆库
+    if (m_translationMemory && m_translationMemory->lookup(cacheKey, translatedText)) {
+        m_translationCache.insert(cacheKey, *translatedText);
+        m_cacheHits++;
+        m_metrics.memoryHits->add();
+        return true;
+    }
+
+    // 相似原文的译文只用于填写本次结果，不写入缓存和记忆库，并记入待审核列表
+    TranslationMemory::FuzzyMatch match;
+    if (m_translationMemory && m_fuzzyThreshold > 0.0
+        && m_translationMemory->fuzzyLookup(task.text, m_fromLang, task.targetLang, m_fuzzyThreshold, &match)) {
+        *translatedText = match.translation;
+        for (int row : task.rows) {
+            TranslationReview review;
+            review.row = row;
+            review.targetLang = task.targetLang;
+            review.sourceText = task.text;
+            review.matchedSource = match.sourceText;
+            review.similarity = match.similarity;
+            m_reviewBuffer.append(review);
+        }
+        m_cacheHits++;
+        m_metrics.fuzzyHits->add();
+        return true;
+    }
+    return false;
+}
+
+void TranslationWorker::storeCache(const TranslationTask &task, const QString &translatedText)
+{
+    QString cacheKey = getCacheKey(task.text, m_fromLang, task.targetLang);
+    m_translationCache.insert(cacheKey, translatedText);
+    if (m_translationMemory) {
+        m_translationMemory->insert(cacheKey, translatedText);
+    }
+}
+
+void TranslationWorker::completeTask(const TranslationTask &task, const QString &translatedText)
+{
+    for (int row : task.rows) {
+        TranslationResult result;
+        result.row = row;
+        result.targetLang = task.targetLang;
+        result.text = translatedText;
+        m_resultBuffer.append(result);
+    }
+    m_completedTranslations += task.rows.size();
+    m_metrics.cellsCompleted->add(task.rows.size());
+}
+
+void TranslationWorker::flushResults()
+{
+    TranslationProgress progress;
+    progress.results.swap(m_resultBuffer);
+    progress.completed = m_completedTranslations;
+    progress.requestCount = m_requestCount;
+    progress.cacheHits = m_cacheHits;
+    progress.requestedTexts = m_requestedTexts;
+    progress.elapsedMs = m_elapsed.elapsed();
+    progress.requestTimings.swap(m_timingBuffer);
+    progress.failures.swap(m_failureBuffer);
+    progress.reviews.swap(m_reviewBuffer);
+    progress.retryCount = m_retryCount;
+    emit progressUpdated(progress);
 }
 
-QString TranslationWorker::generateSign(const QString &query, const QString &salt)
+void TranslationWorker::abortInFlight()
 {
-    QString str = m_appId + query + salt + m_secretKey;
-    QByteArray hash = QCryptographicHash::hash(str.toUtf8(), QCryptographicHash::Md5);
-    return hash.toHex();
+    // abort()会同步触发finished，先清空表避免重入
+    const QList<QNetworkReply *> replies = m_inFlight.keys();
+    for (const InFlightRequest &inFlight : m_inFlight) {
+        m_backends[inFlight.backendIndex].concurrency->release();
+    }
+    m_metrics.inFlight->add(-m_inFlight.size());
+    m_inFlight.clear();
+    for (BackendSlot &slot : m_backends) {
+        slot.inFlight = 0;
+    }
+    for (QNetworkReply *reply : replies) {
+        reply->disconnect(this);
+        reply->abort();
+        reply->deleteLater();
+    }
+}
+
+void TranslationWorker::checkFinished()
+{
+    if (m_finished || !m_pendingTasks.isEmpty() || !m_inFlight.isEmpty() || m_waitingRetries > 0) {
+        return;
+    }
+
+    m_finished = true;
+    m_dispatchTimer->stop();
+    m_flushTimer->stop();
+    flushResults();
+    emit logMessage(QString(u8"工作线程%1结束，共发送%2次翻译请求").arg(m_workerIndex + 1).arg(m_requestCount));
+    if (m_backends.size() > 1) {
+        for (const BackendSlot &slot : m_backends) {
+            emit logMessage(QString(u8"  %1: %2次").arg(slot.backend->name()).arg(slot.requestCount));
+        }
+    }
+    if (!isStopped()) {
+        emit translationFinished();
+    }
 }
 
 QString TranslationWorker::getCacheKey(const QString &text, const QString &from, const QString &to)
 {
-    return QString("%1-%2-%3").arg(from, to, text.trimmed());
+    return TranslationMemory::makeKey(text, from, to);
+}
+
+MetricCounter *TranslationWorker::errorMetric(const QString &code)
+{
+    // 错误码事先未知，每个线程记住已经取得的计数，同一错误码只到注册表查找一次
+    MetricCounter *&metric = m_errorMetrics[code];
+    if (!metric) {
+        metric = MetricsRegistry::instance()->counter(kMetricRequestErrors, "code", code);
+    }
+    return metric;
 }
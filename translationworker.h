@@ -2,7 +2,6 @@
 #define TRANSLATIONWORKER_H
 
 #include <QObject>
-#include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QUrlQuery>
@@ -11,52 +10,201 @@
 #include <QJsonArray>
 #include <QCryptographicHash>
 #include <QDateTime>
-#include <QMutex>
-#include <QMutexLocker>
-#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QQueue>
+#include <QSharedPointer>
+#include <QVector>
 #include <QTimer>
 #include <QSslConfiguration>
 #include <QSslSocket>
 #include <QDebug>
+#include "cancellationtoken.h"
+#include "concurrencycontroller.h"
+#include "metricsregistry.h"
+#include "networksession.h"
+#include "ratelimiter.h"
+#include "retrypolicy.h"
+#include "translationbackend.h"
+#include "translationmemory.h"
+#include "translationworkqueue.h"
 
+// 一个单元格的翻译结果，row不含标题行
+struct TranslationResult
+{
+    int row = -1;
+    QString targetLang;
+    QString text;
+};
+
+// 多次重试仍失败的单元格，翻译结束后汇总到失败列表
+struct TranslationFailure
+{
+    int row = -1;
+    QString targetLang;
+    QString sourceText;
+    QString reason;
+};
+
+// 使用翻译记忆库中相似原文的译文填写的单元格，需要人工审核
+struct TranslationReview
+{
+    int row = -1;
+    QString targetLang;
+    QString sourceText;
+    QString matchedSource;  // 记忆库中与之相似的原文
+    double similarity = 0.0;
+};
+
+// 工作线程定时汇总后发给界面的一批进度
+struct TranslationProgress
+{
+    QVector<TranslationResult> results;
+    int completed = 0;
+    int total = 0;          // 工作线程发出的进度中为0，由调度器填写
+    int requestCount = 0;
+    int cacheHits = 0;      // 缓存或翻译记忆库命中的唯一文本数
+    int requestedTexts = 0; // 发送给接口的唯一文本数
+    int retryCount = 0;     // 失败后重试的请求数
+    int concurrencyWindow = 0; // 各账号当前并发窗口之和，由调度器填写
+    qint64 elapsedMs = 0;
+    QVector<RequestTiming> requestTimings; // 本批次完成的请求各阶段耗时
+    QVector<TranslationFailure> failures;
+    QVector<TranslationReview> reviews;
+};
+
+Q_DECLARE_METATYPE(TranslationProgress)
+
+// 单次请求合并文本的默认字节上限，实际还受各翻译接口自身的上限限制
+const int kDefaultMaxBatchBytes = 6000;
+
+// 一个翻译工作线程：从共享的工作队列取任务，用所在线程的网络会话发送请求
 class TranslationWorker : public QObject
 {
     Q_OBJECT
 
 public:
     explicit TranslationWorker(QObject *parent = nullptr);
-    void setConfig(const QString &appId, const QString &secretKey);
-    void setTranslationData(const QStringList &sourceTexts, const QString &fromLang, const QStringList &targetLangs, bool forceRetranslate);
-    void setExistingTranslations(const QHash<QString, QHash<int, QString>> &existingTranslations);
-    void setDelayTime(int delayMs);
+    ~TranslationWorker();
+    // 会话必须与工作对象位于同一线程，由NetworkSessionPool提供
+    void setNetworkSession(NetworkSession *session);
+    void setWorkQueue(const QSharedPointer<TranslationWorkQueue> &workQueue, int workerIndex);
+    void setFromLang(const QString &fromLang);
+    // 添加一个翻译账号，每个账号有独立的限速器和并发窗口，任务在各账号间轮流分配
+    void addBackend(const QSharedPointer<TranslationBackend> &backend, const QSharedPointer<RateLimiter> &rateLimiter,
+                    const QSharedPointer<ConcurrencyController> &concurrency);
+    void setTranslationMemory(const QSharedPointer<TranslationMemory> &translationMemory);
+    void setMaxBatchBytes(int maxBatchBytes);
+    void setRetryPolicy(const RetryPolicy &retryPolicy);
+    // 翻译记忆库中没有相同原文时，使用相似度不低于threshold的原文的译文，0表示不使用
+    void setFuzzyThreshold(double threshold);
+    // 同一次翻译的所有工作线程共享一个取消标志，任一线程取消时全部立即停止
+    void setCancellationToken(const QSharedPointer<CancellationToken> &cancellation);
     void stopTranslation();
 
 public slots:
     void startTranslation();
 
 signals:
-    void progressUpdated(int current, int total, const QString &currentText, const QString &translatedText, const QString &targetLang);
+    void progressUpdated(const TranslationProgress &progress);
     void translationFinished();
+    // 取消后在途请求已中止、已完成的结果已发出，工作对象可以删除
+    void translationStopped();
     void translationError(const QString &error);
     void logMessage(const QString &message);
 
+private slots:
+    // 在并发上限内尽可能多地发出请求
+    void dispatchPending();
+
+    // 把积累的结果一次性发给界面
+    void flushResults();
+
+    // 取消标志被设置时在本线程中执行，中止在途请求并清空待发任务
+    void onCancelled();
+
 private:
-    QString translateText(const QString &text, const QString &from, const QString &to);
-    QString generateSign(const QString &query, const QString &salt);
+    struct BackendSlot
+    {
+        QSharedPointer<TranslationBackend> backend;
+        QSharedPointer<RateLimiter> rateLimiter;
+        QSharedPointer<ConcurrencyController> concurrency;
+        int inFlight = 0;
+        int requestCount = 0;
+        MetricCounter *requestsMetric = nullptr;         // 按账号的请求数和计费字符数
+        MetricCounter *billedCharactersMetric = nullptr;
+    };
+
+    // 每个请求或任务都要更新的指标，构造时从注册表取一次，之后只做原子操作
+    struct Metrics
+    {
+        MetricCounter *requestBytes = nullptr;
+        MetricCounter *responseBytes = nullptr;
+        MetricGauge *inFlight = nullptr;
+        MetricHistogram *requestDuration = nullptr;
+        MetricHistogram *requestTtfb = nullptr;
+        MetricHistogram *parseDuration = nullptr;
+        MetricCounter *retries = nullptr;
+        MetricCounter *cacheHits = nullptr;
+        MetricCounter *memoryHits = nullptr;
+        MetricCounter *fuzzyHits = nullptr;
+        MetricCounter *cellsCompleted = nullptr;
+    };
+
+    struct InFlightRequest
+    {
+        int backendIndex = -1;
+        int characters = 0; // 发送的原文字符数，按此计费
+        QVector<TranslationTask> tasks;
+    };
+
+    bool isStopped() const;
+    bool takeWorkUnit();
+    int acquireBackend(int *waitMs);
+    QVector<TranslationTask> takeBatch(int maxBatchBytes);
+    void sendRequest(int backendIndex, const QVector<TranslationTask> &batch);
+    void onReplyFinished(QNetworkReply *reply);
+    bool parseReply(QNetworkReply *reply, const TranslationBackend *backend, QStringList *sources, QStringList *results,
+                    RetryAction *action, QString *reason);
+    void handleFailure(int backendIndex, const QVector<TranslationTask> &batch, RetryAction action, const QString &reason);
+    void failTask(const TranslationTask &task, const QString &reason);
+    bool lookupCache(const TranslationTask &task, QString *translatedText);
+    void storeCache(const TranslationTask &task, const QString &translatedText);
+    void completeTask(const TranslationTask &task, const QString &translatedText);
+    void abortInFlight();
+    void checkFinished();
     QString getCacheKey(const QString &text, const QString &from, const QString &to);
+    MetricCounter *errorMetric(const QString &code);
 
-    QString m_appId;
-    QString m_secretKey;
-    QStringList m_sourceTexts;
     QString m_fromLang;
-    QStringList m_targetLangs;
-    bool m_forceRetranslate;
-    bool m_shouldStop;
-    int m_delayTime = 50;
-    QMutex m_mutex;
-    QNetworkAccessManager *m_networkManager;
+    QSharedPointer<TranslationWorkQueue> m_workQueue;
+    int m_workerIndex = 0;
+    bool m_finished = false;
+    int m_maxBatchBytes = kDefaultMaxBatchBytes;
+    int m_completedTranslations = 0;
+    int m_requestCount = 0;
+    int m_cacheHits = 0;
+    int m_requestedTexts = 0;
+    int m_nextBackend = 0;
+    int m_retryCount = 0;
+    int m_waitingRetries = 0; // 正在退避等待重试的任务数
+    RetryPolicy m_retryPolicy;
+    double m_fuzzyThreshold = 0.0;
+    QSharedPointer<CancellationToken> m_cancellation;
+    NetworkSession *m_session = nullptr;
+    QTimer *m_dispatchTimer;
+    QTimer *m_flushTimer;
+    QElapsedTimer m_elapsed;
+    QVector<TranslationResult> m_resultBuffer;
+    QVector<RequestTiming> m_timingBuffer;
+    QVector<TranslationFailure> m_failureBuffer;
+    QVector<TranslationReview> m_reviewBuffer;
+    QVector<BackendSlot> m_backends;
+    QSharedPointer<TranslationMemory> m_translationMemory;
+    QQueue<TranslationTask> m_pendingTasks;
+    QHash<QNetworkReply *, InFlightRequest> m_inFlight;
     QHash<QString, QString> m_translationCache;
-    QHash<QString, QHash<int, QString>> m_existingTranslations;
+    Metrics m_metrics;
+    QHash<QString, MetricCounter *> m_errorMetrics; // 错误码 -> 计数，首次出现时取得
 };
 
 #endif // TRANSLATIONWORKER_H
@@ -0,0 +1,64 @@
+﻿#include "translationworkqueue.h"
+
+#include <QMutexLocker>
+
+TranslationWorkQueue::TranslationWorkQueue(int workerCount)
+    : m_queues(qMax(1, workerCount))
+{
+}
+
+int TranslationWorkQueue::workerCount() const
+{
+    return m_queues.size();
+}
+
+void TranslationWorkQueue::push(int workerIndex, const TranslationWorkUnit &unit)
+{
+    QMutexLocker locker(&m_mutex);
+    m_queues[workerIndex % m_queues.size()].append(unit);
+}
+
+bool TranslationWorkQueue::take(int workerIndex, TranslationWorkUnit *unit, bool *stolen)
+{
+    QMutexLocker locker(&m_mutex);
+    QList<TranslationWorkUnit> &own = m_queues[workerIndex % m_queues.size()];
+    if (!own.isEmpty()) {
+        *unit = own.takeFirst();
+        if (stolen) {
+            *stolen = false;
+        }
+        return true;
+    }
+
+    // 从剩余单元最多的队列尾部窃取，与该队列的所有者从两端取，互不抢同一段行
+    int victim = -1;
+    for (int i = 0; i < m_queues.size(); ++i) {
+        if (!m_queues[i].isEmpty() && (victim == -1 || m_queues[i].size() > m_queues[victim].size())) {
+            victim = i;
+        }
+    }
+    if (victim == -1) {
+        return false;
+    }
+
+    *unit = m_queues[victim].takeLast();
+    m_stolenCount++;
+    if (stolen) {
+        *stolen = true;
+    }
+    return true;
+}
+
+void TranslationWorkQueue::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    for (QList<TranslationWorkUnit> &queue : m_queues) {
+        queue.clear();
+    }
+}
+
+int TranslationWorkQueue::stolenCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stolenCount;
+}
@@ -0,0 +1,48 @@
+#ifndef TRANSLATIONWORKQUEUE_H
+#define TRANSLATIONWORKQUEUE_H
+
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+// 单个翻译任务：一条去重后的源文本、使用它的所有行（不含标题行）和目标语言
+struct TranslationTask
+{
+    QVector<int> rows;
+    QString text;
+    QString targetLang;
+    bool single = false; // 含换行或批量结果无法对应时单独请求
+    int attempts = 0;    // 已失败的次数
+};
+
+// 一个工作单元：同一目标语言中一段连续行的去重任务
+struct TranslationWorkUnit
+{
+    QString targetLang;
+    QVector<TranslationTask> tasks;
+};
+
+// 多个工作线程共享的工作队列，每个线程一个双端队列
+// 线程优先从自己队列的头部取，自己的做完后从剩余最多的队列尾部窃取
+class TranslationWorkQueue
+{
+public:
+    explicit TranslationWorkQueue(int workerCount);
+
+    int workerCount() const;
+    void push(int workerIndex, const TranslationWorkUnit &unit);
+
+    // 取一个工作单元，没有剩余时返回false；stolen表示是否从其他线程的队列窃取
+    bool take(int workerIndex, TranslationWorkUnit *unit, bool *stolen = nullptr);
+
+    void clear();
+    int stolenCount() const;
+
+private:
+    mutable QMutex m_mutex;
+    QVector<QList<TranslationWorkUnit>> m_queues;
+    int m_stolenCount = 0;
+};
+
+#endif // TRANSLATIONWORKQUEUE_H